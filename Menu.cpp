@@ -41,18 +41,14 @@
 #include <Arduino.h>
 #include <Menu.h>
 
+#ifndef pgm_read_ptr                                    //Older avr-libc
+#define pgm_read_ptr(address) ((const void *) pgm_read_word(address))
+#endif
+
 //Constructor=================================================================
 Menu::Menu(String items) {
-  MYitems = items;  //Full menu
-	//Find the number of items of the menu (count the colons)
-	//and allocate memory for the nodes
-	int count = 0;
-	for (int i = 0; i < MYitems.length(); i++)
-		if (MYitems.charAt(i) == ':') count++;
-	nodes = (node*) calloc(count + 1, sizeof(node));
-	nodes[0].eldest = 1;  //The first item in the menu is the eldest of nodes[0]
-
-	menuParse();          //Parse "MYitems" in "nodes[]"
+  MYitems = items;      //Full menu
+	menuParse();          //Parse "MYitems" in "nodes[]" (the table grows as the items are found)
   currentNode = 1;      //Set first node as curent
 }//Constructor-----------------------------------------------------------------
 
@@ -75,6 +71,11 @@ Menu::Menu(String items) {
 //  the label of the item
 //  a colon (:) (token)
 //  a 3 digits number between "000" and "999" ("000" means: I have a submenu) to tag an action to be performed in the sketch
+//A value item adds a 5th part, between brackets, right after the action (which can not be "000"):
+//  "--VOLUME:201[0..10]"            a number between 0 and 10
+//  "--MODE:202[AUTO|MANUAL|OFF]"    one of a list (its index: 0, 1, 2)
+//  "--SENSOR A1:203[?]"             a live value, read only ([?4] shows 4 characters instead of MENU_LIVE_WIDTH)
+//The value is shown at the end of the item's row (cut to the LCD's width less 2). bindValue() ties it to a variable or a getter.
 //In order to navigate the menu, each item is associated to a node : 
 //  struct node {       //For each item :
 //    int starts = 0;     //The index of the start of the label in MYitems
@@ -83,51 +84,222 @@ Menu::Menu(String items) {
 //    int eldest = 1;     //The node number of the eldest child of this item
 //    int action = 0;     //The action associated to this item
 //  };
+//The menu is read only once, and never past its last character.
+//The first item must be at level 1, and an item can be at most one level deeper than the one before it.
+//At most MENU_MAX_LEVELS levels and 255 items are allowed.
+//Parsing stops at the first error. getParseError() tells what went wrong (See MENU_ERR_xxx in Menu.h)
+//and getParseErrorPosition() where it happened in the menu. The items found before the error are kept.
 //-----------------------------------------------------------------------------------------------------------------------------
 void Menu::menuParse() {
-  int stack[8] = { 0,0,0,0,0,0,0,0 }; //Stack (Last-in/First-out) (parent management)
-  int stackPtr = 7;                   //Stack pointer
-  int pos = 1;                        //The position of the pointer in the string "MYitems"
-  int item = 1;                       //The pointer to the current item
-  int curLevel = 1;                   //The level of the current item
-  int nextLevel = 1;                  //The level of the next item
-  int len = MYitems.length();         //The length of "MYitems"
-  
-  while(pos < len) {                                               //Parse the whole menu
-    nodes[item].eldest = 1;                                          //Default value. "I have no child"
-    nodes[item].starts = pos;                                        //The start of the label
-    while(MYitems.charAt(pos) != ':') pos++;                         //Forward to the ":" token
-    nodes[item].ends = pos;                                          //The end of the label
-    nodes[item].action = MYitems.substring(pos+1, pos+4).toInt();    //The integer associated to the action
-	  nodes[item].parent = stack[stackPtr];                            //The parent of the item (current on stack)
-	  pos += 4;                                                        //Forward to the next item
-    nextLevel = 0 ;
-    while(MYitems.charAt(pos) == '-') { pos++; nextLevel++; }        //Find the level of the next item (count dashes)
-    if (nextLevel > curLevel) {                                      //If the next item has a higher level (item is a parent)
-		  stackPtr--; stack[stackPtr] = item;                              //Push the item as a parent on the stack
-      nodes[item].eldest = item + 1;                                   //The next item is the eldest child of the current item
+  byte parents[MENU_MAX_LEVELS + 1] = { 0 }; //The last item seen at each level (parents[0] is nodes[0], the root)
+  int pos = 0;                               //The position of the pointer in the string "MYitems"
+  int item = 0;                              //The pointer to the current item
+  int prevLevel = 0;                         //The level of the previous item
+  int len = MYitems.length();                //The length of "MYitems"
+
+  parseError = MENU_OK;
+  parseErrorAt = 0;
+  if (!growNodes(2)) { parseFailed(MENU_ERR_MEMORY, 0); lastNode = 0; return; }   //No node at all: the menu stays empty
+  nodes[0].starts = 0;  nodes[0].ends = 0;                           //nodes[0] is the root of the menu
+  nodes[0].parent = 0;  nodes[0].eldest = 1;  nodes[0].action = 0;   //The first item in the menu is the eldest of nodes[0]
+  if (len == 0) parseFailed(MENU_ERR_EMPTY, 0);
+
+  while (pos < len) {                                                         //Parse the whole menu
+    int dashes = pos;                                                           //Where the item starts
+    int level = 0;
+    while (pos < len && MYitems.charAt(pos) == '-') { pos++; level++; }         //Find the level of the item (count dashes)
+    if (level == 0)               { parseFailed(MENU_ERR_LEVEL, pos); break; }
+    if (level > prevLevel + 1)    { parseFailed(MENU_ERR_LEVEL_JUMP, dashes); break; }
+    if (level > MENU_MAX_LEVELS)  { parseFailed(MENU_ERR_TOO_DEEP, dashes); break; }
+    int starts = pos;                                                           //The start of the label
+    while (pos < len && MYitems.charAt(pos) != ':') pos++;                      //Forward to the ":" token
+    if (pos == len)               { parseFailed(MENU_ERR_NO_COLON, starts); break; }
+    if (pos == starts)            { parseFailed(MENU_ERR_EMPTY_LABEL, starts); break; }
+    int ends = pos++;                                                           //The end of the label
+    int action = 0;
+    int digits = 0;
+    while (digits < 3 && pos < len && isDigit(MYitems.charAt(pos))) {          //The integer associated to the action
+      action = action * 10 + (MYitems.charAt(pos) - '0');
+      pos++; digits++;
     }
-    if (nextLevel < curLevel) {                                      //If the next item has a lower level
-		  for (int i = nextLevel; i < curLevel; i++) {                     //For the number of generations 
-		    stack[stackPtr] = 0;  stackPtr++;                                //Pull as many parents as necessary off the stack 
-      }                              
+    if (digits < 3 || (pos < len && isDigit(MYitems.charAt(pos)))) { parseFailed(MENU_ERR_ACTION, ends + 1); break; }
+    if (pos < len && MYitems.charAt(pos) == '[') {                              //A value item
+      int valueEnds = valueParse(pos, len);
+      if (valueEnds < 0 || action == 0) { parseFailed(MENU_ERR_VALUE, pos); break; }
+      pos = valueEnds;
     }
-    item++; curLevel = nextLevel;                                   //Go to next item
+    if (item == 255)              { parseFailed(MENU_ERR_TOO_MANY, dashes); break; }
+    if (!growNodes(item + 2))     { parseFailed(MENU_ERR_MEMORY, dashes); break; }
+    item++;                                                                     //The item is valid, give it a node
+    nodes[item].starts = starts;
+    nodes[item].ends = ends;
+    nodes[item].parent = parents[level - 1];                                    //The parent of the item (last item seen one level up)
+    nodes[item].eldest = 1;                                                     //Default value. "I have no child"
+    nodes[item].action = action;
+    if (level > prevLevel) nodes[parents[level - 1]].eldest = item;             //The first item of a level is the eldest child of its parent
+    parents[level] = item;
+    prevLevel = level;
   }
-  lastNode = item-1;                                                //Set "lastNode" to the number of items in the menu
+
+  if (item == 0) {                                                            //No valid item: keep an empty one so that the menu can still be displayed
+    nodes[1].starts = 0;  nodes[1].ends = 0;
+    nodes[1].parent = 0;  nodes[1].eldest = 1;  nodes[1].action = 0;
+    item = 1;
+  }
+  lastNode = item;                                                            //Set "lastNode" to the number of items in the menu
+  node *fitted = (node*) realloc(nodes, (lastNode + 1) * sizeof(node));       //Give back the unused nodes
+  if (fitted != NULL) { nodes = fitted; nodesSize = lastNode + 1; }
 }//menuParse-------------------------------------------------------------------------------------------------------------------
 
+//valueParse========================================================================
+//Checks the value part of an item, "[" being at "pos".
+//Returns the position that follows the "]", or -1 if the value part is not valid.
+//-----------------------------------------------------------------------------------
+int Menu::valueParse(int pos, int len) {
+  int ends = pos + 1;
+  while (ends < len && MYitems.charAt(ends) != ']') ends++;         //Find the closing bracket
+  if (ends == len) return -1;
+  int i = pos + 1;
+  if (MYitems.charAt(i) == '?') {                                    //Live: [?] or [?n]
+    if (ends == i + 1) return ends + 1;
+    char width = MYitems.charAt(i + 1);
+    if (ends == i + 2 && width >= '1' && width <= '9') return ends + 1;
+    return -1;
+  }
+  bool isEnum = false;
+  for (int j = i; j < ends; j++) if (MYitems.charAt(j) == '|') isEnum = true;
+  if (isEnum) {                                                      //Enum: [A|B|C], no empty option
+    int starts = i;
+    for (int j = i; j <= ends; j++) {
+      char c = MYitems.charAt(j);
+      if (c == '|' || c == ']') {
+        if (j == starts) return -1;
+        starts = j + 1;
+      }
+      if (c == '[' || c == ':') return -1;
+    }
+    return ends + 1;
+  }
+  int dots = i;                                                      //Range: [min..max], min < max
+  if (MYitems.charAt(dots) == '-') dots++;
+  int digits = dots;
+  while (dots < ends && isDigit(MYitems.charAt(dots))) dots++;
+  if (dots == digits || dots - digits > 5 || MYitems.charAt(dots) != '.' || MYitems.charAt(dots + 1) != '.') return -1;
+  int j = dots + 2;
+  if (j < ends && MYitems.charAt(j) == '-') j++;
+  digits = j;
+  while (j < ends && isDigit(MYitems.charAt(j))) j++;
+  if (j == digits || j - digits > 5 || j != ends) return -1;
+  long minimum = MYitems.substring(i, dots).toInt();
+  long maximum = MYitems.substring(dots + 2, ends).toInt();
+  if (minimum < -32768 || maximum > 32767 || minimum >= maximum) return -1;
+  return ends + 1;
+}//valueParse-----------------------------------------------------------------------
+
+//growNodes=====================================================================
+//Makes sure that "nodes[]" can hold "count" nodes.
+//The table is doubled each time it is full. Returns false if memory is lacking.
+//------------------------------------------------------------------------------
+bool Menu::growNodes(int count) {
+  if (count <= nodesSize) return true;
+  int size = (nodesSize == 0) ? MENU_NODES_CHUNK : nodesSize * 2;
+  if (size < count) size = count;
+  node *grown = (node*) realloc(nodes, size * sizeof(node));
+  if (grown == NULL) return false;
+  nodes = grown;
+  nodesSize = size;
+  return true;
+}//growNodes--------------------------------------------------------------------
+
+//parseFailed================================================
+//Remembers the first error found while parsing the menu
+//-----------------------------------------------------------
+void Menu::parseFailed(int error, int position) {
+  if (parseError != MENU_OK) return;
+  parseError = error;
+  parseErrorAt = position;
+}//parseFailed-----------------------------------------------
+
+//getParseError===============================================
+//Returns MENU_OK or the kind of error found in the menu
+//------------------------------------------------------------
+int Menu::getParseError() {
+  return parseError;
+}//getParseError----------------------------------------------
+
+//getParseErrorPosition=======================================
+//Returns the index in the menu String where the error was found
+//------------------------------------------------------------
+int Menu::getParseErrorPosition() {
+  return parseErrorAt;
+}//getParseErrorPosition--------------------------------------
+
 //label=====================================================================
-//Return the label of the item "node"
+//Return the label of the item "node" in the current language
+//Language 0 is the menu String itself. The other ones are read from flash.
+//If the pool has no label for "node", the one of the menu String is used.
 //--------------------------------------------------------------------------
 String Menu::label(int node) {
+  if (nodes == NULL) return "";
+  if (language > 0) {
+    const char *pool = (const char *) pgm_read_ptr(&MYlanguages[language - 1]);
+    int item = 1;
+    char c;
+    while (item < node && (c = pgm_read_byte(pool)) != '\0') {   //Skip the labels of the previous items
+      if (c == ':') item++;
+      pool++;
+    }
+    int length = 0;
+    while ((c = pgm_read_byte(pool + length)) != '\0' && c != ':') length++;   //Measure it first,
+    if (item == node && length > 0) {
+      String text;
+      text.reserve(length);                                       //so that the String is allocated once
+      for (int i = 0; i < length; i++) text += (char) pgm_read_byte(pool + i);
+      return text;
+    }
+  }
   return MYitems.substring(nodes[node].starts, nodes[node].ends);
 }//label--------------------------------------------------------------------
 
+//setLanguages================================================================
+//Gives the library the labels of the other languages.
+//"pools" is a table, in PROGMEM, of "count" strings, also in PROGMEM.
+//Each string holds the labels of all the items, in the order of the menu,
+//each one followed by a colon:
+//  const char menuFR[] PROGMEM = "LIRE:CAPTEURS:CAPTEUR A1:CAPTEUR A2:...";
+//  const char * const languages[] PROGMEM = { menuFR, menuES };
+//  menu.setLanguages(languages, 2);
+//The menu is parsed only once: the languages share its nodes and use no RAM.
+//----------------------------------------------------------------------------
+void Menu::setLanguages(const char * const *pools, int count) {
+  MYlanguages = pools;
+  languagesCount = count;
+  if (language > languagesCount) setLanguage(0);
+}//setLanguages---------------------------------------------------------------
+
+//setLanguage=================================================================
+//Selects the labels to display:
+//0 for the menu String, 1 to "count" for the pools given to setLanguages()
+//----------------------------------------------------------------------------
+void Menu::setLanguage(int newLanguage) {
+  if (newLanguage < 0 || newLanguage > languagesCount) return;
+  language = newLanguage;
+  lcdNeedsUpdate = true;
+  if (handelingLcd) showMenu();
+}//setLanguage----------------------------------------------------------------
+
+//getLanguage================================
+//Returns the language of the labels
+//-------------------------------------------
+int Menu::getLanguage() {
+  return language;
+}//getLanguage-------------------------------
+
 //parent===================================================
 //Return the number of the parent of "node"
 //---------------------------------------------------------
 int Menu::parent(int node) {
+    if (nodes == NULL) return 0;
     return nodes[node].parent;
 }//parent--------------------------------------------------
 
@@ -135,6 +307,7 @@ int Menu::parent(int node) {
 //Return the eldest child of "node"
 //--------------------------------------------------
 int Menu::eldest(int node) {
+  if (nodes == NULL) return 1;
   return nodes[node].eldest;
 }//eldest-------------------------------------------
 
@@ -184,6 +357,170 @@ int Menu::siblingsCount(int node) {
   return count;
 }//siblingsCount------------------------------------------------------------------------
 
+//valueKind================================================================
+//Returns the kind of value of "node" (MENU_VALUE_xxx)
+//The value part, if any, follows the 3 digits of the action.
+//--------------------------------------------------------------------------
+int Menu::valueKind(int node) {
+  if (nodes == NULL) return MENU_VALUE_NONE;
+  int at = nodes[node].ends + 4;
+  if (nodes[node].action == 0 || MYitems.charAt(at) != '[') return MENU_VALUE_NONE;   //Node 0 and submenus have no value
+  if (MYitems.charAt(at + 1) == '?') return MENU_VALUE_LIVE;
+  for (int i = at + 1; MYitems.charAt(i) != ']'; i++)
+    if (MYitems.charAt(i) == '|') return MENU_VALUE_ENUM;
+  return MENU_VALUE_RANGE;
+}//valueKind----------------------------------------------------------------
+
+//valueOption===============================================================
+//Returns the text of option "index" of an enum value, or "" if there is none.
+//"count" receives the number of options.
+//--------------------------------------------------------------------------
+String Menu::valueOption(int node, int index, int *count) {
+  int i = nodes[node].ends + 5;
+  int starts = i;
+  String option = "";
+  *count = 0;
+  while (true) {
+    char c = MYitems.charAt(i);
+    if (c == '|' || c == ']') {
+      if (*count == index) option = MYitems.substring(starts, i);
+      (*count)++;
+      starts = i + 1;
+      if (c == ']') return option;
+    }
+    i++;
+  }
+}//valueOption--------------------------------------------------------------
+
+//valueLimits==================================================
+//Sets "minimum" and "maximum" to the limits of the value of "node"
+//For an enum, these are the indexes of its first and last options
+//-------------------------------------------------------------
+void Menu::valueLimits(int node, int *minimum, int *maximum) {
+  int at = nodes[node].ends + 5;
+  *minimum = 0;
+  *maximum = 0;
+  if (valueKind(node) == MENU_VALUE_ENUM) {
+    int count;
+    valueOption(node, 0, &count);
+    *maximum = count - 1;
+  }
+  if (valueKind(node) == MENU_VALUE_RANGE) {
+    int dots = MYitems.indexOf("..", at);
+    *minimum = MYitems.substring(at, dots).toInt();
+    *maximum = MYitems.substring(dots + 2, MYitems.indexOf(']', dots)).toInt();
+  }
+}//valueLimits-------------------------------------------------
+
+//valueWidth==================================================
+//Returns the number of columns used by the value of "node"
+//At most LCDcol - 2: the caret and a space stay on the line
+//------------------------------------------------------------
+int Menu::valueWidth(int node) {
+  int width = 0;
+  switch (valueKind(node)) {
+    case MENU_VALUE_LIVE: {
+      char c = MYitems.charAt(nodes[node].ends + 6);
+      width = (c == ']') ? MENU_LIVE_WIDTH : c - '0';
+      break;
+    }
+    case MENU_VALUE_ENUM: {
+      int count;
+      valueOption(node, 0, &count);
+      for (int i = 0; i < count; i++) {
+        int length = valueOption(node, i, &count).length();
+        if (length > width) width = length;
+      }
+      break;
+    }
+    case MENU_VALUE_RANGE: {
+      int minimum, maximum;
+      valueLimits(node, &minimum, &maximum);
+      width = String(minimum).length();
+      if ((int) String(maximum).length() > width) width = String(maximum).length();
+      break;
+    }
+  }
+  if (width > LCDcol - 2) width = LCDcol - 2;                   //Longer values are cut
+  if (width < 0) width = 0;
+  return width;
+}//valueWidth-------------------------------------------------
+
+//valueField=====================================================
+//Returns "value" as shown for "node", right aligned on its width
+//---------------------------------------------------------------
+String Menu::valueField(int node, int value, bool bound) {
+  int width = valueWidth(node);
+  String text = "";
+  if (bound) {
+    int count;
+    if (valueKind(node) == MENU_VALUE_ENUM) text = valueOption(node, value, &count);
+    else                                    text = String(value);
+  }
+  if ((int) text.length() > width) text = text.substring(0, width);
+  String field = "";
+  for (int i = text.length(); i < width; i++) field += ' ';
+  return field + text;
+}//valueField----------------------------------------------------
+
+//bindValue=====================================================================
+//Ties the value items tagged "action" to a variable of the sketch.
+//Range and enum items are edited in place: RIGHT to start, UP and DOWN to change
+//the variable, LEFT or RIGHT to stop. Live items just show the variable.
+//------------------------------------------------------------------------------
+void Menu::bindValue(int action, int *variable) {
+  bindValue(action, variable, NULL);
+}//bindValue--------------------------------------------------------------------
+
+//bindValue=================================================
+//Ties the live items tagged "action" to a getter function.
+//The getter is called every MENU_VALUE_REFRESH milliseconds
+//while the item is on the LCD.
+//----------------------------------------------------------
+void Menu::bindValue(int action, int (*getter)()) {
+  bindValue(action, NULL, getter);
+}//bindValue------------------------------------------------
+
+//bindValue===============================================================
+//Adds (or replaces) the binding of every value item tagged "action"
+//------------------------------------------------------------------------
+void Menu::bindValue(int action, int *variable, int (*getter)()) {
+  for (int i = 1; i <= lastNode; i++) {
+    if (nodes[i].action != action || valueKind(i) == MENU_VALUE_NONE) continue;
+    if (getter != NULL && valueKind(i) != MENU_VALUE_LIVE) continue;   //Only live items can use a getter
+    binding *bound = findBinding(i);
+    if (bound == NULL) {
+      binding *grown = (binding*) realloc(bindings, (bindingsCount + 1) * sizeof(binding));
+      if (grown == NULL) return;
+      bindings = grown;
+      bound = &bindings[bindingsCount++];
+      bound->node = i;
+    }
+    bound->variable = variable;
+    bound->getter = getter;
+    bound->shown = readValue(bound);
+  }
+  valuesShown = true;
+  lcdNeedsUpdate = true;
+}//bindValue--------------------------------------------------------------
+
+//findBinding===============================================
+//Returns the binding of "node", or NULL if it is not bound
+//----------------------------------------------------------
+Menu::binding *Menu::findBinding(int node) {
+  for (int i = 0; i < bindingsCount; i++)
+    if (bindings[i].node == node) return &bindings[i];
+  return NULL;
+}//findBinding----------------------------------------------
+
+//readValue========================================
+//Returns the value of a binding
+//-------------------------------------------------
+int Menu::readValue(binding *bound) {
+  if (bound->variable != NULL) return *bound->variable;
+  return bound->getter();
+}//readValue---------------------------------------
+
 //getCurrentItem==========================================
 //Returns the current node
 //--------------------------------------------------------
@@ -197,9 +534,12 @@ int Menu::getCurrentItem() {
 void Menu::setCurrentItem(String theLabel) {
   int foundAt = 0;
 	for (int i = 1; i <= lastNode; i++) {
-    if (label(i) = theLabel) foundAt = i;
+    if (label(i) == theLabel) foundAt = i;
 	}
-  if (foundAt > 0) currentNode = foundAt;
+  if (foundAt > 0) {
+    currentNode = foundAt;
+    editing = false;                //The value being edited is no longer the current item
+  }
 }//setCurrentItem------------------------------------------
 
 
@@ -207,6 +547,7 @@ void Menu::setCurrentItem(String theLabel) {
 //Returns the action associated to the current node
 //---------------------------------------------------
 int Menu::getAction() {
+  if (nodes == NULL) return 0;
   return nodes[currentNode].action;
 }//getAction-----------------------------------------
 
@@ -222,6 +563,7 @@ String Menu::getCurrentLabel() {
 //-------------------------
 void Menu::restart() {
   currentNode = 1;
+  editing = false;
 }//restart-----------------
 
 //updated===============================
@@ -235,6 +577,7 @@ void Menu::updated() {
 //Signals that the LCD needs to be updated
 //------------------------------------------
 bool Menu::needsUpdate() {
+  if (!lcdNeedsUpdate && !handelingLcd) refreshValues();  //A value shown by the sketch may have changed
   return lcdNeedsUpdate;
 }//needsUpdate------------------------------
 
@@ -283,36 +626,72 @@ void Menu::defineLcd(int columns, int rows) {
   handelingLcd = false;
 }//defineLcd---------------------------------------------------
 
-//lcdLine==================================================================================================================================
-//Return a string containing the label of the item to be displayed
-//on the "requested Line" on the lcd for the current menu or submenu.
-//Preceded by a caret ">" if the item is the current item.
+//lineNode=================================================================================================================================
+//Return the node of the item to be displayed on the "requested Line" on the lcd for the current menu or submenu.
+//Returns 0 if there is no item on that line.
 //-----------------------------------------------------------------------------------------------------------------------------------------
-String Menu::lcdLine(int requestedLine) {
+int Menu::lineNode(int requestedLine) {
 	int currentRank = rank(currentNode);                              //Where the current node is amongst it's siblings
-  if((requestedLine + 1) > siblingsCount(currentNode)) return "";   //There is no item at this rank in the menu
+  if((requestedLine + 1) > siblingsCount(currentNode)) return 0;    //There is no item at this rank in the menu
 	int child = eldest(parent(currentNode));                          //From the eldest
 	int targetRank = requestedLine + 1;                               //Case where the LCD line 0 displays the eldest
 	if (currentRank >= LCDrows) targetRank += currentRank - LCDrows;  //If not, add the difference between the the item and LCD's line count
 	for (int i = 1; i < targetRank; i++)  child = nextSibling(child); //Find the item at "targetRank"
-	if (currentRank == targetRank) return '>' + label(child);         //If it is the curent item, add a ">" before the label
-	else                           return ' ' + label(child);         //If not, add a " " before the label
-}//cdLine-----------------------------------------------------------------------------------------------------------------------------------
+  return child;
+}//lineNode--------------------------------------------------------------------------------------------------------------------------------
+
+//currentLine==============================================
+//Return the line of the LCD where the current item is shown
+//---------------------------------------------------------
+int Menu::currentLine() {
+  int currentRank = rank(currentNode);
+  if (currentRank >= LCDrows) return LCDrows - 1;
+  return currentRank - 1;
+}//currentLine---------------------------------------------
+
+//lcdLine==================================================================================================================================
+//Return a string containing the label of the item to be displayed
+//on the "requested Line" on the lcd for the current menu or submenu.
+//Preceded by a caret ">" if the item is the current item ("*" while its value is edited).
+//A value item fills the whole line, its value being right aligned.
+//-----------------------------------------------------------------------------------------------------------------------------------------
+String Menu::lcdLine(int requestedLine) {
+  int child = lineNode(requestedLine);                              //The item on that line
+  if (child == 0) return "";                                        //There is no item at this rank in the menu
+  char caret = ' ';                                                 //If not the curent item, add a " " before the label
+  if (child == currentNode) caret = editing ? '*' : '>';            //If it is, add a ">" before the label
+  if (valueKind(child) == MENU_VALUE_NONE) return caret + label(child);
+  binding *bound = findBinding(child);                              //A value item:
+  int value = 0;
+  if (bound != NULL) {
+    value = readValue(bound);
+    bound->shown = value;
+    valuesShown = true;                                             //refreshValues() will watch it (also when the sketch draws)
+  }
+  int room = LCDcol - 1 - valueWidth(child);                        //Columns left for the label
+  String text = label(child);
+  if ((int) text.length() >= room) text = text.substring(0, room - 1);
+  while ((int) text.length() < room) text += ' ';
+  return caret + text + valueField(child, value, bound != NULL);
+}//lcdLine-----------------------------------------------------------------------------------------------------------------------------------
 
 //toLCD==========================================================================
 //Sends the string "msg" to the current LCD at column "col" and row "row"
 //-------------------------------------------------------------------------------
 int Menu::toLCD(String msg, int col, int row) {
+  lcdBytesSent += 1 + msg.length();         //setCursor() and the characters
 	switch(LcdId) {
 		case 1: { MYLcd->setCursor(col, row); MYLcd->print(msg); break; }
     case 2: { MYLcdTWI->setCursor(col, row); MYLcdTWI->print(msg); break; }
 	}
+  return msg.length();
 }//toLCD-------------------------------------------------------------------------
 
 //clearLCD==========================
 //Clears the current LCD
 //----------------------------------
 void Menu::clearLCD() {
+  lcdBytesSent++;                           //The clear command
 	switch (LcdId) {
 	case 1: { MYLcd->clear(); break; }
   case 2: { MYLcdTWI->clear(); break; }
@@ -322,16 +701,55 @@ void Menu::clearLCD() {
 //showMenu==============================================================
 //Sends the current menu or submenu to the LCD
 //Is executed only when it needs an update.
+//Redraws are at least MENU_REDRAW_INTERVAL apart, to reduce flickering.
+//A redraw asked for too soon is done by a later call (See timeToNextTick())
 //----------------------------------------------------------------------
 void Menu::showMenu() {
   if (lcdNeedsUpdate) {
+    if (MYclock() - lastRedraw < MENU_REDRAW_INTERVAL) return;
     clearLCD();
+    valuesShown = false;                                            //lcdLine() tells if bound values are shown
 	  for (int i = 0 ; i < LCDrows ; i++)  toLCD(lcdLine(i), 0, i);
-    delay(100);
+    lastRedraw = MYclock();
+    lastRefresh = lastRedraw;
   lcdNeedsUpdate = false;
   }
+  else refreshValues();
 }//showMenu-------------------------------------------------------------
 
+//refreshValues==========================================================
+//Every MENU_VALUE_REFRESH milliseconds, reads the bound values on the LCD.
+//Only the value fields that changed are redrawn.
+//If the sketch handles the LCD, it is told to redraw instead.
+//-----------------------------------------------------------------------
+void Menu::refreshValues() {
+  if (bindingsCount == 0 || !valuesShown) return;
+  if (MYclock() - lastRefresh < MENU_VALUE_REFRESH) return;
+  lastRefresh = MYclock();
+  valuesShown = false;
+  for (int i = 0; i < LCDrows; i++) {
+    int node = lineNode(i);
+    if (node == 0) break;
+    binding *bound = findBinding(node);
+    if (bound == NULL) continue;
+    valuesShown = true;
+    int value = readValue(bound);
+    if (value == bound->shown) continue;
+    if (handelingLcd) drawValue(node, i);
+    else              lcdNeedsUpdate = true;
+  }
+}//refreshValues---------------------------------------------------------
+
+//drawValue============================================================
+//Redraws only the value field of "node", shown on "line" of the LCD
+//---------------------------------------------------------------------
+void Menu::drawValue(int node, int line) {
+  binding *bound = findBinding(node);
+  if (bound == NULL) return;
+  bound->shown = readValue(bound);
+  toLCD(valueField(node, bound->shown, true), LCDcol - valueWidth(node), line);
+}//drawValue-----------------------------------------------------------
+
 //handleSwitches===================================================================
 //Allows the sketch to pass the pin layout of the arrow switches
 //From then on, the library will handle reading the switches to navigate the menu
@@ -391,7 +809,7 @@ void Menu::mapKeys(int UP, int DOWN, int LEFT, int RIGHT) {
 
 //readDigitalKey=======================================================
 //Reads the switch on pin "key". (debounced)
-//500 positive counts can handle most switches in a normal environment.
+//The switch has to read the same 500 times in a row. This can handle most switches in a normal environment.
 //If noise still occurs, increase the number of counts.
 //---------------------------------------------------------------------
 int Menu::readDigitalKey() {
@@ -408,7 +826,8 @@ int Menu::readDigitalKey() {
 	  int stateOld = digitalRead(pinKey);
 	  while (count < 500) {
 	    stateNew = digitalRead(pinKey);
-	    if (stateNew == stateOld) count++; else count--;
+	    if (stateNew == stateOld) count++;
+	    else { count = 0; stateOld = stateNew; }    //It moved (bounce or release): start again
 	  }
   }
   return key;
@@ -456,27 +875,27 @@ int Menu::readKeyWithRepeat(int delayForRepeat, int sensitivity) {
   int tempKey = 0;
 
 	tempKey = readKey();
-  if (tempKey != key) chrono = millis(); //First time around
+  if (tempKey != key) chrono = MYclock(); //First time around
 
   while (true) {
-    while ((!repeating) && (millis() - chrono < sensitivity)) {} //wait
+    while ((!repeating) && (MYclock() - chrono < sensitivity)) {} //wait
 		k = tempKey;
 		tempKey = readKey();
 		if (tempKey == 0) {
       key = 0;
-      chrono = millis();
+      chrono = MYclock();
       repeating = false; 
       return k;
     }
-    if ((!repeating) && (millis() - chrono >= delayForRepeat)) {
+    if ((!repeating) && (MYclock() - chrono >= delayForRepeat)) {
       repeating = true;
       key = tempKey;
-      chrono = millis();
+      chrono = MYclock();
       return key;
     }
-		if ((repeating) && (millis() - chrono >= sensitivity)) {
+		if ((repeating) && (MYclock() - chrono >= sensitivity)) {
       key = tempKey;
-      chrono = millis();
+      chrono = MYclock();
       return key;
     }
   }
@@ -524,10 +943,20 @@ bool Menu::keyPressed() {
 //---------------------------------------------------------------------------------------
 int Menu::update(int key) {
 int node = currentNode;
+  if (editing) return edit(key);
 	if (key == UP) currentNode = previousSibling(currentNode);
 	if (key == DOWN) currentNode = nextSibling(currentNode);
 	if (key == LEFT) if (parent(currentNode) != 0) currentNode = parent(currentNode);
 	if (key == RIGHT) {
+		int kind = valueKind(currentNode);
+		if (kind != MENU_VALUE_NONE) {                                   //A value item: no action for the sketch
+		  binding *bound = findBinding(currentNode);
+		  if (kind != MENU_VALUE_LIVE && bound != NULL && bound->variable != NULL) {
+		    editing = true;                                                //Edit the value in place
+		    drawCaret();
+		  }
+		  return 0;
+		}
 		int action = getAction();
 		if (action > 0) return action;
 		else            if (eldest(currentNode) != 1) currentNode = eldest(currentNode);
@@ -539,17 +968,79 @@ int node = currentNode;
 	return 0;
 }//--------------------------------------------------------------------------------------
 
-//update=====================================
+//edit=======================================================================
+//The value of the current item is being edited.
+//UP and DOWN change the variable (ranges stop at their limits, enums wrap around).
+//LEFT or RIGHT end the edition.
+//Only the value field (or the caret) is redrawn.
+//The edition also ends if the current item can not be edited (any more).
+//---------------------------------------------------------------------------
+int Menu::edit(int key) {
+  binding *bound = findBinding(currentNode);
+  int kind = valueKind(currentNode);
+  bool editable = (bound != NULL && bound->variable != NULL && (kind == MENU_VALUE_RANGE || kind == MENU_VALUE_ENUM));
+  if (key == LEFT || key == RIGHT || !editable) {
+    editing = false;
+    drawCaret();
+    return 0;
+  }
+  int minimum, maximum;
+  valueLimits(currentNode, &minimum, &maximum);
+  int value = *bound->variable;
+  bool wraps = (kind == MENU_VALUE_ENUM);
+  if (key == UP) {
+    if (value < maximum) value++;
+    else if (wraps)      value = minimum;
+  }
+  if (key == DOWN) {
+    if (value > minimum) value--;
+    else if (wraps)      value = maximum;
+  }
+  if (value < minimum) value = minimum;
+  if (value > maximum) value = maximum;
+  if (value == bound->shown && value == *bound->variable) return 0;
+  *bound->variable = value;
+  if (!handelingLcd) lcdNeedsUpdate = true;
+  else if (!lcdNeedsUpdate) drawValue(currentNode, currentLine());
+  return 0;
+}//edit-----------------------------------------------------------------------
+
+//drawCaret=================================================
+//Redraws only the caret of the current item
+//----------------------------------------------------------
+void Menu::drawCaret() {
+  if (!handelingLcd) { lcdNeedsUpdate = true; return; }
+  if (!lcdNeedsUpdate) toLCD(editing ? "*" : ">", 0, currentLine());
+}//drawCaret-----------------------------------------------
+
+//update=================================================================
 //The Library handles the Keypad
-//-------------------------------------------
+//The switches are read at most once every MENU_KEY_POLL milliseconds.
+//With wakeOnKeys(), they are read only after keyInterrupt() or while one is down.
+//The analog keypad is sampled once per read; it is averaged only when a key goes down.
+//A key is acted upon when it is released, without waiting for it.
+//-------------------------------------------------------------------------
 int Menu::update() {
-  int action = 0;
-	if (wasPressed(UP)) action = update(UP);
-	if (wasPressed(DOWN)) action = update(DOWN);
-	if (wasPressed(LEFT)) action = update(LEFT);
-	if (wasPressed(RIGHT)) action = update(RIGHT);
-  return action;
-}//update------------------------------------
+  unsigned long now = MYclock();
+  if (!keyEvent) {
+    if (keysOnInterrupt && heldKey == 0) return 0;      //No switch moved since the last tick
+    if (now - lastKeyPoll < MENU_KEY_POLL) return 0;    //Too soon
+  }
+  keyEvent = false;
+  lastKeyPoll = now;
+  int key;
+  if (switchesAreAnalog) {                              //readAnalogKey() takes 301 samples: avoid it when we can
+    if (analogRead(MYANALOG) > 1000) key = 0;             //One sample shows that no key is down
+    else if (heldKey != 0)           key = heldKey;       //The same key is still down
+    else                             key = readAnalogKey();  //A key went down: find which one
+  }
+  else key = readKey();
+  if (key == heldKey) return 0;                         //Still down or still up
+  int released = heldKey;
+  heldKey = key;
+  if (released == 0) return 0;                          //Just pressed: wait for the release
+  return update(released);
+}//update------------------------------------------------------------------
 
 //update=====================================
 //The keypad returns characters
@@ -584,9 +1075,83 @@ void Menu::done() {
   if (handelingLcd) showMenu();
 }//done-----------------------------------------------------------------------------------------------
 
+//hasPendingWork============================================================
+//Returns true if update() or showMenu() have something to do right now.
+//If not, the sketch can sleep for timeToNextTick() milliseconds.
+//---------------------------------------------------------------------------
+bool Menu::hasPendingWork() {
+  return timeToNextTick() == 0;
+}//hasPendingWork------------------------------------------------------------
+
+//timeToNextTick===========================================================================
+//Returns the number of milliseconds before update() or showMenu() need to be called again:
+//- 0 if a redraw or a switch change is waiting
+//- the time left before a delayed redraw
+//- the time left before the next refresh of the bound values on the LCD
+//- the time left before the next read of the switches (always polled, unless wakeOnKeys())
+//- MENU_NO_DEADLINE if nothing will happen before a key interrupt
+//-----------------------------------------------------------------------------------------
+unsigned long Menu::timeToNextTick() {
+  unsigned long now = MYclock();
+  unsigned long wait = MENU_NO_DEADLINE;
+  if (keyEvent) return 0;
+  if (lcdNeedsUpdate) {
+    if (!handelingLcd) return 0;                                   //The sketch has to redraw
+    unsigned long elapsed = now - lastRedraw;
+    if (elapsed >= MENU_REDRAW_INTERVAL) return 0;
+    wait = MENU_REDRAW_INTERVAL - elapsed;
+  }
+  if (bindingsCount > 0 && valuesShown) {                          //Bound values are on the LCD
+    unsigned long elapsed = now - lastRefresh;
+    if (elapsed >= MENU_VALUE_REFRESH) return 0;
+    if (MENU_VALUE_REFRESH - elapsed < wait) wait = MENU_VALUE_REFRESH - elapsed;
+  }
+  if (handelingSwitches && (!keysOnInterrupt || heldKey != 0)) {  //We have to read the switches
+    unsigned long elapsed = now - lastKeyPoll;
+    if (elapsed >= MENU_KEY_POLL) return 0;
+    if (MENU_KEY_POLL - elapsed < wait) wait = MENU_KEY_POLL - elapsed;
+  }
+  return wait;
+}//timeToNextTick--------------------------------------------------------------------------
+
+//wakeOnKeys===================================================================
+//The sketch attaches an interrupt to the switches (pin change or external)
+//and calls keyInterrupt() from it. From then on, update() reads the switches
+//only when one of them changed, so the sketch may sleep until then.
+//Not for the analog keypad, which can not raise an interrupt.
+//-----------------------------------------------------------------------------
+void Menu::wakeOnKeys() {
+  keysOnInterrupt = true;
+}//wakeOnKeys------------------------------------------------------------------
+
+//keyInterrupt=============================================
+//Signals that a switch changed. Safe to call from an ISR.
+//---------------------------------------------------------
+void Menu::keyInterrupt() {
+  keyEvent = true;
+}//keyInterrupt--------------------------------------------
+
+//useClock=====================================================================
+//Replaces millis() as the time base of the library (millis() by default).
+//Allows replaying recorded key traces under a virtual clock, faster than real time.
+//-----------------------------------------------------------------------------
+void Menu::useClock(unsigned long (*clock)()) {
+  MYclock = clock;
+}//useClock---------------------------------------------------------------------
+
+//lcdBytes===========================================================
+//Returns the number of bytes the library has sent to the LCD controller:
+//the commands (clear and setCursor) and the characters
+//-------------------------------------------------------------------
+unsigned long Menu::lcdBytes() {
+  return lcdBytesSent;
+}//lcdBytes----------------------------------------------------------
+
 //For debugging purposes...
 void Menu::dump() {
-	for (int i = 0; i <= lastNode; i++) {
+	Serial.print("Parse error : "); Serial.print(parseError);
+	Serial.print(" at "); Serial.println(parseErrorAt);
+	for (int i = 0; nodes != NULL && i <= lastNode; i++) {
 		Serial.print(i); Serial.print(" : ");
 		Serial.print(nodes[i].starts); Serial.print(" - ");
 		Serial.print(nodes[i].ends); Serial.print(" - ");
@@ -38,6 +38,34 @@ Boston, MA  02111-1307  USA
 #include <LiquidCrystal.h>
 #include <LiquidTWI.h>
 
+//Errors found while parsing the menu (See getParseError())
+#define MENU_OK              0   //The menu is valid
+#define MENU_ERR_EMPTY       1   //The menu String is empty
+#define MENU_ERR_LEVEL       2   //An item does not start with a dash
+#define MENU_ERR_LEVEL_JUMP  3   //An item is more than one level deeper than the previous one (or the first item is not at level 1)
+#define MENU_ERR_TOO_DEEP    4   //An item has more than MENU_MAX_LEVELS dashes
+#define MENU_ERR_NO_COLON    5   //The label is not followed by a colon
+#define MENU_ERR_EMPTY_LABEL 6   //There is nothing between the dashes and the colon
+#define MENU_ERR_ACTION      7   //The colon is not followed by exactly 3 digits
+#define MENU_ERR_TOO_MANY    8   //More than 255 items
+#define MENU_ERR_MEMORY      9   //Not enough memory for the nodes
+#define MENU_ERR_VALUE       10  //The value part "[...]" is not valid, or its action is "000"
+
+#define MENU_MAX_LEVELS      8   //The deepest level allowed in a menu
+#define MENU_NODES_CHUNK     8   //The initial size of the table of nodes
+
+#define MENU_REDRAW_INTERVAL 100  //The minimum time (ms) between two redraws of the LCD by showMenu()
+#define MENU_KEY_POLL        20   //The time (ms) between two reads of the switches by update()
+#define MENU_NO_DEADLINE     0xFFFFFFFFUL  //timeToNextTick() : nothing to do until a key interrupt
+
+//Value items (See menuParse() in Menu.cpp)
+#define MENU_VALUE_NONE      0    //A plain item
+#define MENU_VALUE_RANGE     1    //[min..max]
+#define MENU_VALUE_ENUM      2    //[A|B|C]
+#define MENU_VALUE_LIVE      3    //[?] Read only
+#define MENU_VALUE_REFRESH   250  //The time (ms) between two reads of the bound values shown on the LCD
+#define MENU_LIVE_WIDTH      6    //The default width of a live value
+
 class Menu {
   public: //===================================================================================================
   //Constructor 
@@ -79,16 +107,39 @@ class Menu {
 		int getCurrentItem();                                                     //Returns the number of the current menu item (currentNode)
     int getAction();            	                                            //Returns the action associated to the current item
 		void setCurrentItem(String label);
+		int getParseError();                                                      //Returns MENU_OK or the MENU_ERR_xxx found in the menu
+		int getParseErrorPosition();                                              //Returns where in the menu String the error was found
+
+    //Value items
+		void bindValue(int action, int *variable);                                //Ties the value items tagged "action" to a variable
+		void bindValue(int action, int (*getter)());                              //Ties the live items tagged "action" to a getter
+
+    //Labels in other languages
+		void setLanguages(const char * const *pools, int count);                  //The label pools (in PROGMEM) of languages 1 to "count"
+		void setLanguage(int language);                                           //0: the labels of the menu String, 1 to "count": the pools
+		int getLanguage();                                                        //Returns the language of the labels
 
  
     //Let the Sketch advise us that
 		void done();                                                              //The action is handled, return to the menu
     void restart();                                                           //Sets currentNode to 1
+
+    //Let the sketch sleep between ticks
+		bool hasPendingWork();                                                    //Is true if update() or showMenu() has something to do right now
+		unsigned long timeToNextTick();                                           //Milliseconds before the menu needs update() or showMenu() again
+		void wakeOnKeys();                                                        //The switches raise an interrupt: stop polling them
+		void keyInterrupt();                                                      //To be called by the sketch's interrupt routine when a switch changes
+
+    //Measuring and replaying
+		void useClock(unsigned long (*clock)());                                  //Replaces millis() as the library's time base
+		unsigned long lcdBytes();                                                 //The number of bytes (commands and characters) sent to the LCD so far
     
     //Extras  
 		void dump(); //debug only
 
   private: //====================================================================================================
+    unsigned long (*MYclock)() = millis;  //The time base (See useClock())
+
     //Default values for the size of the LCD
     int LCDcol = 16;
     int LCDrows = 2;
@@ -105,11 +156,45 @@ class Menu {
       byte eldest = 1;    //the node number of the eldest of this item
       int action = 0;     //the action associated to this item
     };
-	  node *nodes;        //The table that holds the nodes (using calloc() to use only the needed memory)
+	  node *nodes = NULL; //The table that holds the nodes (using realloc() to use only the needed memory)
+    int nodesSize = 0;  //The number of nodes allocated in "nodes[]"
     void menuParse();   //Actual parsing of "MYitems" and setup of "nodes[]"
+    bool growNodes(int count);  //Makes room for "count" nodes in "nodes[]"
+    int parseError = MENU_OK;   //The first error found in "MYitems"
+    int parseErrorAt = 0;       //Where it was found
+    void parseFailed(int error, int position);
 
     //Labels of the menu or submenu to be displayed on the LCD
     String label(int node); //Returns the label of "node"
+    const char * const *MYlanguages = NULL;  //The label pools of the other languages (in PROGMEM)
+    int languagesCount = 0;                  //How many there are
+    int language = 0;                        //The language displayed (0: the menu String)
+
+    //Value items
+    struct binding {    //For each value item tied to the sketch :
+      byte node;          //the node of the item
+      int *variable;      //the variable shown and edited (or NULL)
+      int (*getter)();    //the function that returns a live value (or NULL)
+      int shown;          //the value on the LCD
+    };
+    binding *bindings = NULL;       //The table of bindings (grows with bindValue())
+    int bindingsCount = 0;
+    bool editing = false;           //The value of the current item is being edited
+    bool valuesShown = true;        //Bound values may be on the LCD
+    unsigned long lastRefresh = 0;  //When the bound values were last read
+    int valueParse(int pos, int len);
+    int valueKind(int node);
+    String valueOption(int node, int index, int *count);
+    void valueLimits(int node, int *minimum, int *maximum);
+    int valueWidth(int node);
+    String valueField(int node, int value, bool bound);
+    void bindValue(int action, int *variable, int (*getter)());
+    binding *findBinding(int node);
+    int readValue(binding *bound);
+    void refreshValues();           //Redraws the bound values that changed
+    void drawValue(int node, int line);
+    void drawCaret();
+    int edit(int key);              //UP and DOWN while editing a value
 
     //Moving around the menus
     int currentNode = 1;            //The index of the current node
@@ -120,6 +205,8 @@ class Menu {
     int nextSibling(int node);      //The next sibling of "node"
 		int siblingsCount(int node);    //The number of siblings of "node"
     int rank(int node);             //The rank of "node" amongst it's siblings
+    int lineNode(int line);         //The node shown on "line" of the LCD
+    int currentLine();              //The line of the LCD where the current node is shown
     
   //LCD
     LiquidCrystal *MYLcd;                    //A pointer to the sketche's LCD with 4 data pins
@@ -129,6 +216,8 @@ class Menu {
     int LcdIsFourPins = 1;
     int LcdIsTWI = 2;
     bool lcdNeedsUpdate = true;              //Keeps track of the needs to update the LCD
+    unsigned long lastRedraw = 0UL - MENU_REDRAW_INTERVAL;  //When showMenu() last drew the menu (the first one is not delayed)
+    unsigned long lcdBytesSent = 0;          //Bytes sent to the LCD by toLCD() and clearLCD()
     void clearLCD();
 		int toLCD(String msg, int col, int row);
 
@@ -155,5 +244,9 @@ class Menu {
 	  int readDigitalKey();            //Use four Arduino pins in INPUT_PULLUP mode
 	  int readAnalogKey();             //Use one analog pin
 		bool keysAreIntegers = false;    //The keys sent by the sketch are integers
+		int heldKey = 0;                 //The switch that is down. update() acts when it is released
+		unsigned long lastKeyPoll = 0UL - MENU_KEY_POLL;  //When update() last read the switches
+		bool keysOnInterrupt = false;    //The sketch calls keyInterrupt() when a switch changes
+		volatile bool keyEvent = false;  //A switch changed since the last update()
 };
 #endif
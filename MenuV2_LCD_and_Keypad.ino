@@ -42,8 +42,8 @@ LiquidCrystal lcd(7, 6, 5, 4, 3, 2);           //Constructor for LiquidCrystal
 const String menuItems = 
 "-READ PINS:000"
 "--SENSORS:000"
-"---SENSOR A1:101"
-"---SENSOR A2:102"
+"---SENSOR A1:101[?4]"                         //Live values, shown on the right of the item
+"---SENSOR A2:102[?4]"
 "--SWITCHES:000"
 "---SWITCH PIN 24:103"
 "---SWITCH PIN 26:104"
@@ -52,7 +52,11 @@ const String menuItems =
 "--STOP:106";
 Menu menu(menuItems); //Set up menu
 
-////////////////////////////////////////////////////////////////////////////////////////ACTIONS 101 to 104
+/////////////////////////////////////////////////////////////////////////////////////////LIVE VALUES 101 and 102
+int readA1() { return analogRead(A1); }         //The Menu Library calls them while the items are on the LCD
+int readA2() { return analogRead(A2); }         //and redraws only the values that changed
+
+////////////////////////////////////////////////////////////////////////////////////////ACTIONS 103 and 104
 void readPin(int pin, int pinType) {
   int key = 0;                                          //Initialise key as NoKeyPressed
   lcd.clear();                                          //Clear the LCD
@@ -75,8 +79,6 @@ void readPin(int pin, int pinType) {
 /////////////////////////////////////////////////////////////////////////////////////////////ACTION SELECT
 void make(int action) {
   switch (action) {
-    case 101: { readPin(A1, ANALOG); break; }
-    case 102: { readPin(A2, ANALOG); break; }
     case 103: { readPin(22, DIGITAL); break; }
     case 104: { readPin(24, DIGITAL); break; }
     case 105: { digitalWrite(PINMOTOR, HIGH); break; }
@@ -92,6 +94,8 @@ void setup() {
 //Comment out the Keypad that you are not using  
   menu.handleSwitches(11,10,9,8);                      //Give the pins number of your digital keypad
 //  menu.handleSwitches(A0);                             //Give the pin number of your analog keypad
+  menu.bindValue(101, readA1);                         //Tie the live values to their getters
+  menu.bindValue(102, readA2);
 
   pinMode(22,INPUT_PULLUP);      //Setup for the actions
   pinMode(24,INPUT_PULLUP);
@@ -106,5 +110,9 @@ void loop() {
     make(action);                    //make it.
     menu.done();                     //We are done with this action... Go back to the menu.
   }
+  if (!menu.hasPendingWork()) {                  //Nothing to do right now:
+    unsigned long wait = menu.timeToNextTick();    //For how long?
+    if (wait != MENU_NO_DEADLINE) delay(wait);     //Replace delay() by your sleep routine to save power
+  }
 }
 
@@ -0,0 +1,27 @@
+/*
+ * check.h
+ * The smallest test helper: CHECK() reports the failures, checkDone() sets the exit code.
+ */
+
+#ifndef check_h
+#define check_h
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+static int checkCount = 0;
+
+#define CHECK(condition) do { checkCount++; \
+  if (!(condition)) { checkFailures++; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); } \
+} while (0)
+
+#define CHECK_EQUAL(actual, expected) do { checkCount++; long a_ = (long) (actual), e_ = (long) (expected); \
+  if (a_ != e_) { checkFailures++; printf("%s:%d: %s is %ld, expected %ld\n", __FILE__, __LINE__, #actual, a_, e_); } \
+} while (0)
+
+static int checkDone(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, checkCount, checkFailures);
+  return checkFailures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * idle_test.cpp
+ * The idle/deadline API under a simulated clock: a sketch that sleeps for
+ * timeToNextTick() must not do any work while nothing happens, and must still
+ * see every key and every redraw in time.
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#include <Menu.h>
+#include "check.h"
+
+#define PIN_UP 11
+#define PIN_DOWN 10
+#define PIN_LEFT 9
+#define PIN_RIGHT 8
+#define SECOND 1000000UL
+
+static const char *items = "-A:000--A1:101--A2:102-B:000--B1:103-C:104";
+static unsigned long busy = 0;     //Microseconds spent in the library by loop()
+static long ticks = 0;             //Calls to loop()
+static int lastAction = 0;
+
+//loop===================================================================
+//The loop() of a sketch that sleeps when the menu has nothing to do.
+//Runs until the virtual clock reaches "until" (in microseconds).
+//-----------------------------------------------------------------------
+static void loop(Menu &menu, unsigned long until) {
+  while (hostMicros < until) {
+    unsigned long start = hostMicros;
+    menu.showMenu();
+    int action = menu.update();
+    if (action > 0) lastAction = action;
+    busy += hostMicros - start;
+    ticks++;
+    if (!menu.hasPendingWork()) {
+      unsigned long wait = menu.timeToNextTick();
+      if (wait == MENU_NO_DEADLINE || hostMicros + wait * 1000 > until) hostMicros = until;
+      else hostAdvance(wait * 1000);
+    }
+  }
+}
+
+static void startCounting() { busy = 0; ticks = 0; hostDigitalReads = 0; hostAnalogReads = 0; }
+
+int main() {
+  //Digital switches on interrupt: asleep until a key =====================================
+  hostReset();
+  LiquidCrystal lcd;
+  lcd.begin(16, 2);
+  Menu menu{String(items)};
+  menu.handleLcd(&lcd, 16, 2);
+  menu.handleSwitches(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT);
+  menu.wakeOnKeys();
+  loop(menu, SECOND);
+  startCounting();
+  loop(menu, 11 * SECOND);
+  CHECK_EQUAL(hostDigitalReads, 0);                               //10 s without any read
+  CHECK(ticks <= 2);
+  CHECK_EQUAL(menu.timeToNextTick(), MENU_NO_DEADLINE);
+
+  unsigned long bytes = lcd.bytes();                              //DOWN: pressed then released 80 ms later
+  hostPins[PIN_DOWN] = LOW; menu.keyInterrupt();
+  CHECK(menu.hasPendingWork());
+  loop(menu, hostMicros + 80000);
+  CHECK_EQUAL(menu.getCurrentItem(), 1);                          //Nothing before the release
+  CHECK(menu.timeToNextTick() <= MENU_KEY_POLL);                  //A key is down: it is polled
+  hostPins[PIN_DOWN] = HIGH; menu.keyInterrupt();
+  unsigned long released = hostMicros;
+  loop(menu, hostMicros + 1);
+  CHECK_EQUAL(menu.getCurrentItem(), 4);                          //B, at once
+  CHECK(lcd.bytes() > bytes);                                     //Redrawn
+  CHECK(lcd.line(1) == String(">B              "));
+  CHECK(hostMicros - released < 20000);
+  loop(menu, hostMicros + SECOND);
+  CHECK_EQUAL(menu.timeToNextTick(), MENU_NO_DEADLINE);           //Asleep again
+
+  hostPins[PIN_DOWN] = LOW; menu.keyInterrupt();                  //DOWN to C, then RIGHT: action 104
+  loop(menu, hostMicros + 50000);
+  hostPins[PIN_DOWN] = HIGH; menu.keyInterrupt();
+  loop(menu, hostMicros + 50000);
+  hostPins[PIN_RIGHT] = LOW; menu.keyInterrupt();
+  loop(menu, hostMicros + 50000);
+  hostPins[PIN_RIGHT] = HIGH; menu.keyInterrupt();
+  loop(menu, hostMicros + 50000);
+  CHECK_EQUAL(lastAction, 104);
+
+  //Redraws are MENU_REDRAW_INTERVAL apart, and the deadline says when ====================
+  menu.update(1);                                                 //Redrawn at once (the last redraw is old)
+  unsigned long clears = lcd.clears;
+  menu.update(1);                                                 //Too soon: left pending
+  CHECK_EQUAL(lcd.clears, clears);
+  CHECK(!menu.hasPendingWork());
+  unsigned long wait = menu.timeToNextTick();
+  CHECK(wait > 0 && wait <= MENU_REDRAW_INTERVAL);
+  hostAdvance(wait * 1000);
+  CHECK(menu.hasPendingWork());
+  menu.showMenu();
+  CHECK_EQUAL(lcd.clears, clears + 1);
+  CHECK_EQUAL(menu.getCurrentItem(), 1);
+
+  //Digital switches, polled: one read of the 4 pins every MENU_KEY_POLL ==================
+  hostReset();
+  Menu polled{String(items)};
+  polled.handleSwitches(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT);
+  loop(polled, SECOND);
+  startCounting();
+  loop(polled, 2 * SECOND);
+  CHECK(hostDigitalReads <= 4 * (1000 / MENU_KEY_POLL + 1));
+  CHECK(busy < SECOND / 100);                                     //Less than 1% busy
+
+  //Analog switches, polled: one sample per poll while idle ===============================
+  hostReset();
+  hostPins[A0] = 1023;
+  Menu analog{String(items)};
+  analog.handleSwitches(A0);
+  loop(analog, SECOND);
+  startCounting();
+  loop(analog, 2 * SECOND);
+  CHECK(hostAnalogReads <= 1000 / MENU_KEY_POLL + 1);
+  CHECK(busy < SECOND / 100);
+  CHECK(ticks <= 2 * (1000 / MENU_KEY_POLL + 1));                 //It sleeps between polls
+  hostPins[A0] = 368;                                             //DOWN (second bin)
+  loop(analog, hostMicros + 100000);
+  CHECK_EQUAL(analog.getCurrentItem(), 1);
+  hostPins[A0] = 1023;
+  loop(analog, hostMicros + 50000);
+  CHECK_EQUAL(analog.getCurrentItem(), 4);
+
+  //The sketch handles the LCD: a redraw is work for it right now =========================
+  hostReset();
+  Menu sketchLcd{String(items)};
+  sketchLcd.defineLcd(16, 2);
+  CHECK(sketchLcd.needsUpdate());
+  CHECK(sketchLcd.hasPendingWork());
+  sketchLcd.updated();
+  CHECK_EQUAL(sketchLcd.timeToNextTick(), MENU_NO_DEADLINE);
+
+  return checkDone("idle_test");
+}
@@ -0,0 +1,73 @@
+/*
+ * languages_test.cpp
+ * Labels in other languages: pools in PROGMEM shared by one parsed menu,
+ * the fallback to the menu String, and the changes of language.
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#define private public            //label() is checked directly
+#include <Menu.h>
+#undef private
+#include "check.h"
+
+static const char *items = "-READ:000--SENSOR:101-MOTOR:000";
+const char menuFR[] PROGMEM = "LIRE:CAPTEUR:MOTEUR:";
+const char menuDE[] PROGMEM = "LESEN:";                 //Short: only the first item
+const char menuES[] PROGMEM = "LEER::MOTOR ES:";        //No label for the second item
+const char * const languages[] PROGMEM = { menuFR, menuDE, menuES };
+
+int main() {
+  hostReset();
+  LiquidCrystal lcd;
+  lcd.begin(16, 2);
+  Menu menu{String(items)};
+  menu.handleLcd(&lcd, 16, 2);
+  menu.setLanguages(languages, 3);
+  CHECK_EQUAL(menu.getLanguage(), 0);
+  CHECK_EQUAL(lcd.line(0).indexOf("READ"), 1);
+
+  //Switching languages redraws with the labels of the pool
+  hostAdvance(MENU_REDRAW_INTERVAL * 1000UL);
+  unsigned long clears = lcd.clears;
+  menu.setLanguage(1);
+  CHECK_EQUAL(menu.getLanguage(), 1);
+  CHECK_EQUAL(lcd.clears, clears + 1);
+  CHECK_EQUAL(lcd.line(0).indexOf("LIRE"), 1);
+  CHECK_EQUAL(lcd.line(1).indexOf("MOTEUR"), 1);
+  CHECK(menu.getCurrentLabel() == "LIRE");
+  CHECK(menu.label(2) == "CAPTEUR");
+
+  //The label is copied from flash into a String sized once, not grown character by character
+  unsigned long allocations = hostAllocations;
+  String label = menu.label(2);
+  CHECK(hostAllocations - allocations <= 3);                      //The empty String, reserve() and the copy to the caller
+
+  //A short pool, or an empty entry, falls back to the menu String
+  menu.setLanguage(2);
+  CHECK(menu.label(1) == "LESEN");
+  CHECK(menu.label(2) == "SENSOR");
+  CHECK(menu.label(3) == "MOTOR");
+  menu.setLanguage(3);
+  CHECK(menu.label(1) == "LEER");
+  CHECK(menu.label(2) == "SENSOR");
+  CHECK(menu.label(3) == "MOTOR ES");
+
+  //Out of range languages are ignored
+  menu.setLanguage(4);
+  CHECK_EQUAL(menu.getLanguage(), 3);
+  menu.setLanguage(-1);
+  CHECK_EQUAL(menu.getLanguage(), 3);
+
+  //Fewer pools: a language that is gone goes back to the menu String
+  menu.setLanguages(languages, 3);
+  CHECK_EQUAL(menu.getLanguage(), 3);
+  menu.setLanguages(languages, 1);
+  CHECK_EQUAL(menu.getLanguage(), 0);
+  CHECK(menu.label(1) == "READ");
+  hostAdvance(MENU_REDRAW_INTERVAL * 1000UL);
+  menu.showMenu();
+  CHECK_EQUAL(lcd.line(0).indexOf("READ"), 1);
+
+  return checkDone("languages_test");
+}
@@ -0,0 +1,60 @@
+/*
+ * legacy_parse.h
+ * The parser of Menu 2.00 (two passes, no validation), kept as the reference
+ * for parse_bench.cpp. It reads past the end of malformed menus: give it valid ones only.
+ */
+
+#ifndef legacy_parse_h
+#define legacy_parse_h
+
+#include <Arduino.h>
+
+struct legacyNode {
+  int starts;
+  int ends;
+  byte parent;
+  byte eldest;
+  int action;
+};
+
+//Returns the table of nodes (free() it) and sets "lastNode"
+static legacyNode *legacyParse(const String &MYitems, int *lastNode) {
+  int count = 0;
+  for (unsigned int i = 0; i < MYitems.length(); i++)
+    if (MYitems.charAt(i) == ':') count++;
+  legacyNode *nodes = (legacyNode*) calloc(count + 1, sizeof(legacyNode));
+  nodes[0].eldest = 1;
+
+  int stack[8] = { 0,0,0,0,0,0,0,0 };
+  int stackPtr = 7;
+  int pos = 1;
+  int item = 1;
+  int curLevel = 1;
+  int nextLevel = 1;
+  int len = MYitems.length();
+  while(pos < len) {
+    nodes[item].eldest = 1;
+    nodes[item].starts = pos;
+    while(MYitems.charAt(pos) != ':') pos++;
+    nodes[item].ends = pos;
+    nodes[item].action = MYitems.substring(pos+1, pos+4).toInt();
+    nodes[item].parent = stack[stackPtr];
+    pos += 4;
+    nextLevel = 0 ;
+    while(MYitems.charAt(pos) == '-') { pos++; nextLevel++; }
+    if (nextLevel > curLevel) {
+      stackPtr--; stack[stackPtr] = item;
+      nodes[item].eldest = item + 1;
+    }
+    if (nextLevel < curLevel) {
+      for (int i = nextLevel; i < curLevel; i++) {
+        stack[stackPtr] = 0;  stackPtr++;
+      }
+    }
+    item++; curLevel = nextLevel;
+  }
+  *lastNode = item - 1;
+  return nodes;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * menu_gen.h
+ * Builds random menus for the fuzz target and the benchmark.
+ */
+
+#ifndef menu_gen_h
+#define menu_gen_h
+
+#include <Arduino.h>
+
+static unsigned long genSeed = 1;
+
+static unsigned long genRandom(unsigned long range) {
+  genSeed = genSeed * 1103515245UL + 12345UL;
+  return (genSeed >> 8) % range;
+}
+
+//A valid menu of "items" items, at most "depth" levels deep
+static String genValidMenu(int items, int depth) {
+  String menu;
+  int level = 1;
+  for (int i = 0; i < items; i++) {
+    for (int d = 0; d < level; d++) menu += '-';
+    menu += "ITEM ";
+    menu += String(i);
+    menu += ':';
+    int action = (level < depth && i + 1 < items && genRandom(3) == 0) ? 0 : 1 + genRandom(999);
+    char digits[4];
+    snprintf(digits, sizeof digits, "%03d", action);
+    menu += digits;
+    if (action == 0) level++;                                   //A submenu: its children follow
+    else if (level > 1 && genRandom(3) == 0) level -= 1 + genRandom(level - 1);
+  }
+  return menu;
+}
+
+//Anything, made mostly of the characters that matter to the parser
+static String genNoise(int length) {
+  static const char alphabet[] = "--::0123456789[]..|?AB -";
+  String menu;
+  for (int i = 0; i < length; i++) menu += alphabet[genRandom(sizeof alphabet - 1)];
+  return menu;
+}
+
+//A valid menu, damaged in a few places
+static String genDamagedMenu() {
+  String menu = genValidMenu(1 + genRandom(20), 1 + genRandom(8));
+  int damages = 1 + genRandom(3);
+  for (int d = 0; d < damages && menu.length() > 0; d++) {
+    unsigned int at = genRandom(menu.length());
+    String noise = genNoise(genRandom(4));
+    menu = menu.substring(0, at) + noise + menu.substring(at + genRandom(3));
+  }
+  return menu;
+}
+
+#endif
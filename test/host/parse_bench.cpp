@@ -0,0 +1,74 @@
+/*
+ * parse_bench.cpp
+ * Parse throughput of the Menu parser against the parser of Menu 2.00 (legacy_parse.h).
+ * Both must give the same node table on valid menus: the benchmark fails if they don't.
+ * parse_bench [repeats]
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#define private public            //The node tables are compared directly
+#include <Menu.h>
+#undef private
+#include <chrono>
+#include "legacy_parse.h"
+#include "menu_gen.h"
+
+#define BENCH_MENUS 100
+
+static double seconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv) {
+  long repeats = argc > 1 ? atol(argv[1]) : 200;
+  const int sizes[] = { 10, 50, 200 };
+  int mismatches = 0;
+  printf("%8s %14s %14s %8s\n", "items", "legacy item/s", "new item/s", "ratio");
+  for (int s = 0; s < 3; s++) {
+    String menus[BENCH_MENUS];
+    long items = 0;
+    for (int m = 0; m < BENCH_MENUS; m++) menus[m] = genValidMenu(sizes[s], MENU_MAX_LEVELS);
+
+    for (int m = 0; m < BENCH_MENUS; m++) {                       //Same result?
+      int legacyLast;
+      legacyNode *legacy = legacyParse(menus[m], &legacyLast);
+      Menu menu(menus[m]);
+      bool same = (menu.getParseError() == MENU_OK && menu.lastNode == legacyLast);
+      for (int i = 0; same && i <= legacyLast; i++) {
+        same = menu.nodes[i].starts == legacy[i].starts && menu.nodes[i].ends == legacy[i].ends
+            && menu.nodes[i].parent == legacy[i].parent && menu.nodes[i].eldest == legacy[i].eldest
+            && menu.nodes[i].action == legacy[i].action;
+      }
+      if (!same) { mismatches++; printf("node tables differ: %s\n", menus[m].c_str()); }
+      free(legacy);
+      free(menu.nodes);
+    }
+
+    double start = seconds();                                      //Legacy
+    for (long r = 0; r < repeats; r++) {
+      for (int m = 0; m < BENCH_MENUS; m++) {
+        int last;
+        legacyNode *legacy = legacyParse(menus[m], &last);
+        items += last;
+        free(legacy);
+      }
+    }
+    double legacyTime = seconds() - start;
+
+    start = seconds();                                             //New
+    for (long r = 0; r < repeats; r++) {
+      for (int m = 0; m < BENCH_MENUS; m++) {
+        Menu menu(menus[m]);
+        items -= menu.lastNode;
+        free(menu.nodes);
+      }
+    }
+    double newTime = seconds() - start;
+    if (items != 0) mismatches++;
+
+    double count = (double) repeats * BENCH_MENUS * sizes[s];
+    printf("%8d %14.0f %14.0f %8.2f\n", sizes[s], count / legacyTime, count / newTime, legacyTime / newTime);
+  }
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * parse_fuzz.cpp
+ * Fuzz target for the menu parser: any input must give a consistent node table,
+ * and navigating and displaying the result must stay within bounds (build with ASan/UBSan).
+ * With libFuzzer (-DMENU_LIBFUZZER -fsanitize=fuzzer), LLVMFuzzerTestOneInput() is the entry point.
+ * Otherwise main() feeds it random, damaged and valid menus:  parse_fuzz [iterations] [seed]
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#define private public            //The node table is checked directly
+#include <Menu.h>
+#undef private
+#include "menu_gen.h"
+
+static int fuzzVariable = 0;
+static int fuzzGetter() { return -12345; }
+
+//checkTree=====================================================================
+//The node table must describe a tree, whatever the menu was
+//------------------------------------------------------------------------------
+static void checkTree(Menu &menu, const String &text) {
+  if (menu.getParseError() < MENU_OK || menu.getParseError() > MENU_ERR_VALUE) abort();
+  if (menu.getParseErrorPosition() < 0 || menu.getParseErrorPosition() > (int) text.length()) abort();
+  if (menu.lastNode < 1 || menu.lastNode > 255 || menu.lastNode >= menu.nodesSize) abort();
+  for (int i = 1; i <= menu.lastNode; i++) {
+    Menu::node &n = menu.nodes[i];
+    if (n.parent >= i) abort();
+    if (n.eldest != 1 && (n.eldest != i + 1 || n.eldest > menu.lastNode || menu.nodes[n.eldest].parent != i)) abort();
+    if (n.starts > n.ends || n.ends > (int) text.length()) abort();
+    if (n.action < 0 || n.action > 999) abort();
+  }
+  if (menu.getParseError() == MENU_OK && text.length() > 0 && menu.lastNode < 1) abort();
+}
+
+//fuzzOne==========================================================================
+//Parses "text", then uses the menu: the keys to press come from the text itself
+//---------------------------------------------------------------------------------
+static void fuzzOne(const String &text) {
+  Menu menu(text);
+  checkTree(menu, text);
+  LiquidCrystal lcd;
+  lcd.begin(16, 2);
+  menu.handleLcd(&lcd, 16, 2);
+  for (int action = 1; action < 1000; action += 97) { menu.bindValue(action, &fuzzVariable); menu.bindValue(action, fuzzGetter); }
+  for (unsigned int i = 0; i < text.length() && i < 64; i++) {
+    menu.update(1 + (text.charAt(i) & 3));
+    hostAdvance(150000UL);
+    menu.showMenu();
+    for (int row = 0; row < 2; row++) menu.lcdLine(row);
+    menu.getCurrentLabel();
+    menu.getAction();
+  }
+  if (lcd.badCursors != 0) abort();
+  free(menu.nodes);
+  free(menu.bindings);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  String text;
+  for (size_t i = 0; i < size && data[i] != 0; i++) text += (char) data[i];
+  fuzzOne(text);
+  return 0;
+}
+
+#ifndef MENU_LIBFUZZER
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : 20000;
+  genSeed = argc > 2 ? atol(argv[2]) : 1;
+  hostReset();
+  long valid = 0;
+  for (long i = 0; i < iterations; i++) {
+    String text;
+    switch (i % 3) {
+      case 0: text = genNoise(genRandom(60)); break;
+      case 1: text = genDamagedMenu(); break;
+      case 2: {
+        text = genValidMenu(1 + genRandom(60), 1 + genRandom(MENU_MAX_LEVELS));
+        Menu menu(text);
+        if (menu.getParseError() != MENU_OK) { printf("valid menu rejected: %s\n", text.c_str()); return 1; }
+        free(menu.nodes);
+        valid++;
+        break;
+      }
+    }
+    fuzzOne(text);
+  }
+  printf("parse_fuzz: %ld menus (%ld valid), no finding\n", iterations, valid);
+  return 0;
+}
+#endif
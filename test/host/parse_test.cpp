@@ -0,0 +1,73 @@
+/*
+ * parse_test.cpp
+ * The errors reported by the parser, and a menu that can not get its nodes.
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#include <Menu.h>
+#include "check.h"
+
+static void checkError(const char *text, int error, int position) {
+  Menu menu{String(text)};
+  if (menu.getParseError() != error || menu.getParseErrorPosition() != position)
+    printf("\"%s\": error %d at %d\n", text, menu.getParseError(), menu.getParseErrorPosition());
+  CHECK_EQUAL(menu.getParseError(), error);
+  CHECK_EQUAL(menu.getParseErrorPosition(), position);
+}
+
+int main() {
+  hostReset();
+
+  checkError("-READ:000--A1:101--A2:102-MOVE:107", MENU_OK, 0);
+  checkError("", MENU_ERR_EMPTY, 0);
+  checkError("READ:000", MENU_ERR_LEVEL, 0);
+  checkError("-A:000x", MENU_ERR_LEVEL, 6);
+  checkError("--A:000", MENU_ERR_LEVEL_JUMP, 0);
+  checkError("-A:000---B:001", MENU_ERR_LEVEL_JUMP, 6);
+  checkError("-A:000--B:000---C:000----D:000-----E:000------F:000-------G:000--------H:000---------I:000", MENU_ERR_TOO_DEEP, 76);
+  checkError("-A", MENU_ERR_NO_COLON, 1);
+  checkError("-:000", MENU_ERR_EMPTY_LABEL, 1);
+  checkError("-A:12", MENU_ERR_ACTION, 3);
+  checkError("-A:1234", MENU_ERR_ACTION, 3);
+  checkError("-A:000-B:00x", MENU_ERR_ACTION, 9);
+  checkError("-A:001[5..5]", MENU_ERR_VALUE, 6);                  //min must be below max
+  checkError("-A:000-B:002[a|]", MENU_ERR_VALUE, 12);             //Empty option
+  checkError("-A:001[?0]", MENU_ERR_VALUE, 6);                    //Live width 1 to 9
+  checkError("-A:001[]", MENU_ERR_VALUE, 6);
+  checkError("-A:000--B:001[0..9", MENU_ERR_VALUE, 13);           //Not closed
+  checkError("-A:000[0..9]", MENU_ERR_VALUE, 6);                  //A submenu has no value
+
+  String many;                                                     //256 items
+  for (int i = 0; i < 256; i++) many += "-I:001";
+  Menu tooMany(many);
+  CHECK_EQUAL(tooMany.getParseError(), MENU_ERR_TOO_MANY);
+  CHECK_EQUAL(tooMany.getParseErrorPosition(), 255 * 6);
+
+  Menu partial{String("-A:001-B:002---C:003")};                   //The items before the error are kept
+  CHECK_EQUAL(partial.getParseError(), MENU_ERR_LEVEL_JUMP);
+  partial.update(2);
+  CHECK(partial.getCurrentLabel() == String("B"));
+  CHECK_EQUAL(partial.update(4), 2);
+
+  bool failedFirst = false;                                        //Out of memory at each allocation, in turn
+  bool failedGrowing = false;
+  for (long fail = 0; fail < 12; fail++) {
+    String text("-A:000--B:001--C:002--D:003--E:004--F:005--G:006--H:007--I:008");
+    hostFailAllocAfter = fail;
+    Menu menu(text);
+    hostFailAllocAfter = -1;
+    if (menu.getParseError() == MENU_ERR_MEMORY && menu.getParseErrorPosition() == 0) failedFirst = true;
+    if (menu.getParseError() == MENU_ERR_MEMORY && menu.getParseErrorPosition() > 0) failedGrowing = true;
+    LiquidCrystal lcd;
+    menu.handleLcd(&lcd, 16, 2);                                   //The menu must still be usable
+    for (int key = 1; key <= 4; key++) menu.update(key);
+    menu.lcdLine(0);
+    menu.getCurrentLabel();
+    CHECK_EQUAL(lcd.badCursors, 0);
+  }
+  CHECK(failedFirst);                                              //No node at all
+  CHECK(failedGrowing);                                            //The table could not grow
+
+  return checkDone("parse_test");
+}
@@ -0,0 +1,360 @@
+/*
+ * replay.cpp
+ * Replays recorded key traces through the Menu Library under the virtual clock
+ * and the mock LCD of shim/, much faster than real time, and reports for each trace:
+ *   - the latency of each keypress (p50, p99, max), from the moment the key is released
+ *     (pressed, for a sketch keypad) to the moment the LCD shows the result
+ *   - the bytes sent to the LCD per keypress
+ *   - the heap high-water mark (host sizes: 32-bit ints and 64-bit pointers)
+ * The replayed loop() is the one of the examples: showMenu(), update(), done() after an action,
+ * then sleep for timeToNextTick().
+ * A polled keypad is read every MENU_KEY_POLL ms: the latency of a key depends on where its release
+ * falls between two polls. Each trace is replayed shifted by every millisecond of MENU_KEY_POLL,
+ * and the metrics are taken over all the runs, so that they do not move with the phase of the polls.
+ * With a thresholds file, exits with 1 if a metric is over its threshold.
+ *
+ *   replay [-t thresholds.txt] trace...
+ *
+ * Trace format (one directive or event per line, # starts a comment):
+ *   menu <the menu String>
+ *   lcd <columns> <rows>
+ *   keypad digital|interrupt|analog|sketch   (handleSwitches() 4 pins, the same with wakeOnKeys(),
+ *                                             handleSwitches(A0), mapKeys() and updateWith())
+ *   bind <action> variable <initial value>   (bindValue() to a variable)
+ *   bind <action> live <period ms>           (bindValue() to a getter whose value changes every period)
+ *   <ms> UP|DOWN|LEFT|RIGHT <held ms>        (a keypress: when it went down, and for how long)
+ * A sketch records such a trace with: Serial.print(millis()); Serial.print(' '); ... on each press and release.
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#include <Menu.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#define PIN_UP 11
+#define PIN_DOWN 10
+#define PIN_LEFT 9
+#define PIN_RIGHT 8
+#define KEYPAD_DIGITAL 0
+#define KEYPAD_INTERRUPT 1
+#define KEYPAD_ANALOG 2
+#define KEYPAD_SKETCH 3
+#define TAIL_US 2000000UL             //Replay 2 s past the last release
+#define MAX_BINDINGS 16
+#define PHASE_STEP_US 1000UL          //The shifts of the runs of a trace: 0, 1, ... MENU_KEY_POLL - 1 ms
+
+struct keyPress {
+  unsigned long press;                //Microseconds
+  unsigned long release;
+  int key;                            //1 to 4 (UP, DOWN, LEFT, RIGHT)
+};
+
+struct trace {
+  std::string name;
+  std::string menu;
+  int columns = 16;
+  int rows = 2;
+  int keypad = KEYPAD_DIGITAL;
+  int bindActions[MAX_BINDINGS];
+  bool bindLive[MAX_BINDINGS];
+  long bindArgument[MAX_BINDINGS];
+  int binds = 0;
+  std::vector<keyPress> presses;
+};
+
+struct results {
+  std::vector<double> latencies;      //Milliseconds, of all the runs
+  unsigned long lcdBytes = 0;         //Sent after the first keypress, of all the runs
+  unsigned long keys = 0;             //Keypresses, of all the runs
+  long heap = 0;
+  double virtualSeconds = 0;
+  double wallSeconds = 0;
+  bool consistent = true;
+};
+
+static const char *keyNames[] = { "", "UP", "DOWN", "LEFT", "RIGHT" };
+static const int keyPins[] = { 0, PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT };
+static const int analogLevels[] = { 1023, 134, 368, 658, 893 };   //Bins of readAnalogKey()
+
+//readTrace====================================================================
+static bool readTrace(const char *path, trace &t) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) { printf("%s: can not open\n", path); return false; }
+  t.name = path;
+  size_t slash = t.name.find_last_of('/');
+  if (slash != std::string::npos) t.name = t.name.substr(slash + 1);
+  char line[1024];
+  int lineNumber = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof line, f)) {
+    lineNumber++;
+    std::string s(line);
+    while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) s.pop_back();
+    size_t start = s.find_first_not_of(" \t");
+    if (start == std::string::npos || s[start] == '#') continue;
+    s = s.substr(start);
+    char word[32];
+    long a = 0, b = 0;
+    if (s.compare(0, 5, "menu ") == 0) t.menu = s.substr(5);
+    else if (sscanf(s.c_str(), "lcd %d %d", &t.columns, &t.rows) == 2) {}
+    else if (sscanf(s.c_str(), "keypad %31s", word) == 1) {
+      std::string k(word);
+      if (k == "digital") t.keypad = KEYPAD_DIGITAL;
+      else if (k == "interrupt") t.keypad = KEYPAD_INTERRUPT;
+      else if (k == "analog") t.keypad = KEYPAD_ANALOG;
+      else if (k == "sketch") t.keypad = KEYPAD_SKETCH;
+      else ok = false;
+    }
+    else if (sscanf(s.c_str(), "bind %ld %31s %ld", &a, word, &b) == 3 && t.binds < MAX_BINDINGS) {
+      t.bindActions[t.binds] = a;
+      t.bindLive[t.binds] = (std::string(word) == "live");
+      t.bindArgument[t.binds] = b;
+      t.binds++;
+    }
+    else if (sscanf(s.c_str(), "%ld %31s %ld", &a, word, &b) == 3) {
+      keyPress p;
+      p.key = 0;
+      for (int k = 1; k <= 4; k++) if (std::string(word) == keyNames[k]) p.key = k;
+      p.press = a * 1000UL;
+      p.release = (a + b) * 1000UL;
+      if (p.key == 0 || b <= 0 || (!t.presses.empty() && p.press <= t.presses.back().release)) ok = false;
+      else t.presses.push_back(p);
+    }
+    else ok = false;
+  }
+  fclose(f);
+  if (!ok) printf("%s:%d: not valid\n", path, lineNumber);
+  if (ok && (t.menu.empty() || t.presses.empty())) { printf("%s: no menu or no keypress\n", path); ok = false; }
+  return ok;
+}
+
+//The replayed sketch=========================================================
+static trace *current;
+static unsigned long shift;           //Microseconds added to the times of the trace in this run
+static size_t applied;                //Edges (press and release) already applied to the pins
+static unsigned long lastRead;        //When the library last read a pin
+static int boundVariables[MAX_BINDINGS];
+static Menu *menu;
+
+static unsigned long edgeTime(size_t edge) {
+  const keyPress &p = current->presses[edge / 2];
+  return shift + ((edge % 2 == 0) ? p.press : p.release);
+}
+
+static void setPins(int key) {
+  for (int k = 1; k <= 4; k++) hostPins[keyPins[k]] = (k == key) ? LOW : HIGH;
+  hostPins[A0] = analogLevels[key];
+}
+
+//Applies the edges that are due. Returns the key pressed by the last edge applied (sketch keypad)
+static int applyEdges() {
+  int pressed = 0;
+  while (applied < current->presses.size() * 2 && edgeTime(applied) <= hostMicros) {
+    bool down = (applied % 2 == 0);
+    int key = current->presses[applied / 2].key;
+    setPins(down ? key : 0);
+    if (current->keypad == KEYPAD_INTERRUPT) menu->keyInterrupt();
+    if (down) pressed = key;
+    applied++;
+  }
+  return pressed;
+}
+
+static void beforeRead() {
+  if (current->keypad != KEYPAD_SKETCH) applyEdges();
+  lastRead = hostMicros;
+}
+
+//A live value: changes every "period" ms
+static long livePeriods[MAX_BINDINGS];
+static int liveValue(int i) { return (int) ((hostMicros / 1000) / livePeriods[i]); }
+static int live0() { return liveValue(0); }
+static int live1() { return liveValue(1); }
+static int live2() { return liveValue(2); }
+static int live3() { return liveValue(3); }
+static int (*liveGetters[])() = { live0, live1, live2, live3 };
+
+//replay=======================================================================
+//One run of trace "t", its times shifted by "by" microseconds. Adds its metrics to "r".
+//-----------------------------------------------------------------------------
+static void replay(trace &t, unsigned long by, results &r) {
+  current = &t;
+  shift = by;
+  applied = 0;
+  lastRead = 0;
+  hostReset();
+  setPins(0);
+  hostBeforeRead = beforeRead;
+  LiquidCrystal lcd;
+  lcd.begin(t.columns, t.rows);
+  String items(t.menu.c_str());
+  long heapBefore = hostHeapInUse;
+  hostHeapResetPeak();
+  menu = new Menu(items);
+  if (menu->getParseError() != MENU_OK) {
+    printf("%s: menu error %d at %d\n", t.name.c_str(), menu->getParseError(), menu->getParseErrorPosition());
+    r.consistent = false;
+  }
+  menu->handleLcd(&lcd, t.columns, t.rows);
+  switch (t.keypad) {
+    case KEYPAD_DIGITAL: menu->handleSwitches(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT); break;
+    case KEYPAD_INTERRUPT: menu->handleSwitches(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT); menu->wakeOnKeys(); break;
+    case KEYPAD_ANALOG: menu->handleSwitches(A0); break;
+    case KEYPAD_SKETCH: menu->mapKeys(1, 2, 3, 4); break;
+  }
+  int lives = 0;
+  for (int i = 0; i < t.binds; i++) {
+    if (t.bindLive[i] && lives < 4) {
+      livePeriods[lives] = t.bindArgument[i] > 0 ? t.bindArgument[i] : 1;
+      menu->bindValue(t.bindActions[i], liveGetters[lives++]);
+    }
+    if (!t.bindLive[i]) {
+      boundVariables[i] = t.bindArgument[i];
+      menu->bindValue(t.bindActions[i], &boundVariables[i]);
+    }
+  }
+
+  size_t latencies = r.latencies.size();
+  size_t waiting = 0;                  //The keypress whose result is awaited
+  bool seen = false;                   //The library has seen its key
+  bool started = false;                //The first key went down
+  unsigned long lcdBytesAtFirstPress = 0;
+  unsigned long end = shift + t.presses.back().release + TAIL_US;
+  double wallStart = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  while (hostMicros < end) {
+    int pressed = applyEdges();                                     //Edges due while the sketch slept
+    if (!started && applied > 0) {                                  //The first drawing is not counted
+      started = true;
+      lcdBytesAtFirstPress = lcd.bytes();
+    }
+    menu->showMenu();                                               //loop()
+    int action = 0;
+    if (t.keypad == KEYPAD_SKETCH) { if (pressed) { action = menu->updateWith(pressed); seen = true; } }
+    else action = menu->update();
+    if (action > 0) {
+      if (t.keypad == KEYPAD_SKETCH) { menu->updateLcd(); menu->showMenu(); }
+      else menu->done();
+    }
+    if (waiting < t.presses.size()) {                               //Latency of the keypress awaited
+      const keyPress &p = t.presses[waiting];
+      unsigned long from = shift + ((t.keypad == KEYPAD_SKETCH) ? p.press : p.release);
+      if (t.keypad != KEYPAD_SKETCH) seen = (hostMicros >= from && lastRead >= from);
+      if (seen && !menu->needsUpdate()) {
+        r.latencies.push_back((hostMicros - from) / 1000.0);
+        waiting++;
+        seen = false;
+      }
+    }
+    if (!menu->hasPendingWork()) {                                  //Sleep
+      unsigned long wake = end;
+      unsigned long wait = menu->timeToNextTick();
+      if (wait != MENU_NO_DEADLINE) wake = std::min(wake, hostMicros + wait * 1000);
+      if (t.keypad != KEYPAD_DIGITAL && t.keypad != KEYPAD_ANALOG && applied < t.presses.size() * 2)
+        wake = std::min(wake, edgeTime(applied));                   //Woken by the key interrupt (or the sketch's keypad)
+      if (t.keypad == KEYPAD_SKETCH && waiting < t.presses.size() && seen)
+        wake = hostMicros;                                          //The sketch redraws at once
+      if (wake > hostMicros) hostMicros = wake;
+      else hostAdvance(10);
+    }
+    else hostAdvance(10);                                           //The rest of loop()
+  }
+  r.lcdBytes += lcd.bytes() - lcdBytesAtFirstPress;
+  r.keys += t.presses.size();
+  r.wallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() - wallStart;
+  r.virtualSeconds += hostMicros / 1e6;
+  if (r.latencies.size() - latencies != t.presses.size()) {
+    printf("%s: %zu keypresses, %zu results seen\n", t.name.c_str(), t.presses.size(), r.latencies.size() - latencies);
+    r.consistent = false;
+  }
+  if (menu->lcdBytes() != lcd.bytes()) {
+    printf("%s: lcdBytes() is %lu, the LCD got %lu\n", t.name.c_str(), menu->lcdBytes(), lcd.bytes());
+    r.consistent = false;
+  }
+  if (lcd.badCursors != 0) {
+    printf("%s: %lu setCursor() outside of the LCD\n", t.name.c_str(), lcd.badCursors);
+    r.consistent = false;
+  }
+  r.heap = std::max(r.heap, hostHeapPeak - heapBefore);
+  delete menu;
+  hostBeforeRead = NULL;
+}
+
+//percentile==============================================
+//Nearest rank percentile of sorted "values"
+//--------------------------------------------------------
+static double percentile(const std::vector<double> &values, int p) {
+  if (values.empty()) return 0;
+  return values[(values.size() * p + 99) / 100 - 1];
+}
+
+//Thresholds===================================================================
+struct threshold {
+  std::string name;
+  double p50, p99, max, lcdBytesPerKey;
+  long heap;
+};
+
+static bool readThresholds(const char *path, std::vector<threshold> &list) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) { printf("%s: can not open\n", path); return false; }
+  char line[256];
+  while (fgets(line, sizeof line, f)) {
+    char name[128];
+    threshold t;
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%127s %lf %lf %lf %lf %ld", name, &t.p50, &t.p99, &t.max, &t.lcdBytesPerKey, &t.heap) != 6) continue;
+    t.name = name;
+    list.push_back(t);
+  }
+  fclose(f);
+  return true;
+}
+
+static bool over(const char *trace, const char *metric, double value, double limit) {
+  if (value <= limit) return false;
+  printf("REGRESSION %s: %s is %.2f, threshold %.2f\n", trace, metric, value, limit);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::vector<threshold> thresholds;
+  bool checking = false;
+  bool failed = false;
+  int first = 1;
+  if (argc > 2 && std::string(argv[1]) == "-t") {
+    if (!readThresholds(argv[2], thresholds)) return 1;
+    checking = true;
+    first = 3;
+  }
+  printf("%-28s %5s %8s %8s %8s %10s %8s %9s\n", "trace", "keys", "p50 ms", "p99 ms", "max ms", "LCD B/key", "heap B", "speedup");
+  for (int i = first; i < argc; i++) {
+    trace t;
+    if (!readTrace(argv[i], t)) { failed = true; continue; }
+    results r;
+    r.latencies.reserve(t.presses.size() * (MENU_KEY_POLL * 1000UL / PHASE_STEP_US));   //Not counted in the heap of the menu
+    for (unsigned long by = 0; by < MENU_KEY_POLL * 1000UL; by += PHASE_STEP_US) replay(t, by, r);
+    std::sort(r.latencies.begin(), r.latencies.end());
+    double p50 = percentile(r.latencies, 50);
+    double p99 = percentile(r.latencies, 99);
+    double max = r.latencies.empty() ? 0 : r.latencies.back();
+    double lcdBytesPerKey = r.keys ? (double) r.lcdBytes / r.keys : 0;
+    printf("%-28s %5zu %8.2f %8.2f %8.2f %10.1f %8ld %8.0fx\n", t.name.c_str(), t.presses.size(),
+           p50, p99, max, lcdBytesPerKey, r.heap, r.wallSeconds > 0 ? r.virtualSeconds / r.wallSeconds : 0);
+    if (!r.consistent) failed = true;
+    if (!checking) continue;
+    const threshold *limit = NULL;
+    for (size_t j = 0; j < thresholds.size(); j++) if (thresholds[j].name == t.name) limit = &thresholds[j];
+    if (limit == NULL) { printf("%s: no threshold\n", t.name.c_str()); failed = true; continue; }
+    const char *n = t.name.c_str();
+    if (over(n, "p50", p50, limit->p50)) failed = true;
+    if (over(n, "p99", p99, limit->p99)) failed = true;
+    if (over(n, "max", max, limit->max)) failed = true;
+    if (over(n, "LCD bytes per key", lcdBytesPerKey, limit->lcdBytesPerKey)) failed = true;
+    if (over(n, "heap", r.heap, limit->heap)) failed = true;
+  }
+  return failed ? 1 : 0;
+}
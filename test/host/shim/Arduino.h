@@ -0,0 +1,119 @@
+/*
+ * Arduino.h (host shim)
+ * Just enough of the Arduino core to build the Menu Library on a PC.
+ * Time is virtual: it only moves when the simulated hardware works (see host.cpp),
+ * when delay() is called, or when a test moves it with hostAdvance().
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef uint8_t byte;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define A0 54
+#define A1 55
+#define A2 56
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const unsigned char *)(address))
+#define pgm_read_word(address) (*(const unsigned short *)(address))
+#define pgm_read_ptr(address) (*(const void * const *)(address))
+
+//Simulated hardware (host.cpp)==============================================
+#define HOST_PINS 64
+#define HOST_COST_MILLIS        1     //Microseconds taken by millis()
+#define HOST_COST_DIGITAL_READ  5     //Microseconds taken by digitalRead()
+#define HOST_COST_ANALOG_READ   112   //Microseconds taken by analogRead() (AVR, 16 MHz)
+extern unsigned long hostMicros;      //The virtual clock
+extern int hostPins[HOST_PINS];       //What digitalRead() and analogRead() return
+extern unsigned long hostDigitalReads;
+extern unsigned long hostAnalogReads;
+extern void (*hostBeforeRead)();      //Called before each read (lets a test change the pins as time goes)
+void hostAdvance(unsigned long us);   //Moves the virtual clock
+void hostReset();                     //Clock at 0, pins HIGH, counters at 0
+
+//Heap accounting (host.cpp, when built with HOST_HEAP)
+extern long hostHeapInUse;            //Bytes allocated right now
+extern long hostHeapPeak;             //High-water mark of hostHeapInUse
+extern long hostFailAllocAfter;       //Fail that many allocations from now (-1: never)
+extern unsigned long hostAllocations;  //malloc(), calloc() and realloc() calls that succeeded
+void hostHeapResetPeak();
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+int digitalRead(int pin);
+int analogRead(int pin);
+void digitalWrite(int pin, int value);
+void pinMode(int pin, int mode);
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+//String=====================================================================
+//Same storage as the Arduino String: one malloc()'ed buffer, grown with realloc()
+class String {
+  public:
+    String(const char *text = "");
+    String(const String &other);
+    explicit String(char c);
+    explicit String(int value);
+    explicit String(unsigned int value);
+    explicit String(long value);
+    explicit String(unsigned long value);
+    ~String();
+    String &operator=(const String &other);
+    String &operator+=(const String &other) { append(other.buffer, other.len); return *this; }
+    String &operator+=(const char *text) { append(text, strlen(text)); return *this; }
+    String &operator+=(char c) { append(&c, 1); return *this; }
+    bool operator==(const String &other) const { return len == other.len && memcmp(buffer, other.buffer, len) == 0; }
+    bool operator!=(const String &other) const { return !(*this == other); }
+    typedef void (String::*StringIfHelperType)() const;    //As the Arduino String: "if (aString)"
+    void StringIfHelper() const {}
+    operator StringIfHelperType() const { return buffer ? &String::StringIfHelper : 0; }
+    unsigned int length() const { return len; }
+    char charAt(unsigned int index) const { return index < len ? buffer[index] : 0; }
+    String substring(unsigned int from) const { return substring(from, len); }
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const char *text, unsigned int from = 0) const;
+    long toInt() const { return atol(buffer); }
+    bool reserve(unsigned int size);
+    const char *c_str() const { return buffer; }
+  private:
+    char *buffer = NULL;
+    unsigned int len = 0;
+    unsigned int capacity = 0;
+    void append(const char *text, unsigned int count);
+};
+String operator+(const String &left, const String &right);
+String operator+(const String &left, const char *right);
+String operator+(const String &left, char right);
+String operator+(char left, const String &right);
+String operator+(const char *left, const String &right);
+
+//Serial=====================================================================
+class HostSerial {
+  public:
+    void begin(long) {}
+    void print(const String &s) { if (echo) fputs(s.c_str(), stdout); }
+    void print(const char *s) { if (echo) fputs(s, stdout); }
+    void print(long v) { if (echo) printf("%ld", v); }
+    void println(const String &s) { print(s); print("\n"); }
+    void println(const char *s) { print(s); print("\n"); }
+    void println(long v) { print(v); print("\n"); }
+    void println() { print("\n"); }
+    bool echo = false;
+};
+extern HostSerial Serial;
+
+#endif
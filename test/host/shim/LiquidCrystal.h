@@ -0,0 +1,43 @@
+/*
+ * LiquidCrystal.h (host shim)
+ * A mock HD44780 LCD: keeps what is on the screen and counts the bytes
+ * (commands and characters) sent to the controller.
+ * Each byte costs the time the real library takes to send it (4 bits mode).
+ */
+
+#ifndef LiquidCrystal_h
+#define LiquidCrystal_h
+
+#include <Arduino.h>
+
+#define HOST_LCD_MAX_COLS 40
+#define HOST_LCD_MAX_ROWS 4
+#define HOST_COST_LCD_BYTE  205    //Microseconds for one command or character
+#define HOST_COST_LCD_CLEAR 2000   //Extra microseconds for clear()
+
+class LiquidCrystal {
+  public:
+    LiquidCrystal() { begin(16, 2); }
+    LiquidCrystal(int, int, int, int, int, int) { begin(16, 2); }
+    void begin(int columns, int rows);
+    void clear();
+    void setCursor(int column, int row);    //Same silent uint8_t wrap as the real one: errors are counted
+    size_t write(char c);
+    size_t print(const String &s);
+    size_t print(const char *s) { return print(String(s)); }
+    size_t print(int value) { return print(String(value)); }
+    String line(int row);                   //What is on "row" of the screen
+    unsigned long commands = 0;             //Commands sent (clear, setCursor)
+    unsigned long characters = 0;           //Characters sent
+    unsigned long clears = 0;
+    unsigned long badCursors = 0;           //setCursor() outside of the screen
+    unsigned long bytes() { return commands + characters; }
+  private:
+    int cols = 16;
+    int rows = 2;
+    int col = 0;
+    int row = 0;
+    char screen[HOST_LCD_MAX_ROWS][HOST_LCD_MAX_COLS];
+};
+
+#endif
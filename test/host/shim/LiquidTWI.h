@@ -0,0 +1,16 @@
+/*
+ * LiquidTWI.h (host shim)
+ * Same mock as LiquidCrystal.
+ */
+
+#ifndef LiquidTWI_h
+#define LiquidTWI_h
+
+#include <LiquidCrystal.h>
+
+class LiquidTWI : public LiquidCrystal {
+  public:
+    LiquidTWI(int) {}
+};
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * host.cpp (host shim)
+ * The simulated hardware behind Arduino.h and LiquidCrystal.h
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+
+HostSerial Serial;
+
+//Virtual clock and pins=====================================================
+unsigned long hostMicros = 0;
+int hostPins[HOST_PINS];
+unsigned long hostDigitalReads = 0;
+unsigned long hostAnalogReads = 0;
+void (*hostBeforeRead)() = NULL;
+
+void hostAdvance(unsigned long us) { hostMicros += us; }
+
+void hostReset() {
+  hostMicros = 0;
+  for (int i = 0; i < HOST_PINS; i++) hostPins[i] = HIGH;
+  hostDigitalReads = 0;
+  hostAnalogReads = 0;
+  hostBeforeRead = NULL;
+}
+
+unsigned long millis() { hostMicros += HOST_COST_MILLIS; return hostMicros / 1000; }
+unsigned long micros() { hostMicros += HOST_COST_MILLIS; return hostMicros; }
+void delay(unsigned long ms) { hostMicros += ms * 1000; }
+void delayMicroseconds(unsigned int us) { hostMicros += us; }
+void pinMode(int, int) {}
+void digitalWrite(int pin, int value) { if (pin >= 0 && pin < HOST_PINS) hostPins[pin] = value; }
+
+int digitalRead(int pin) {
+  if (hostBeforeRead) hostBeforeRead();
+  hostMicros += HOST_COST_DIGITAL_READ;
+  hostDigitalReads++;
+  return (pin >= 0 && pin < HOST_PINS) ? hostPins[pin] : LOW;
+}
+
+int analogRead(int pin) {
+  if (hostBeforeRead) hostBeforeRead();
+  hostMicros += HOST_COST_ANALOG_READ;
+  hostAnalogReads++;
+  return (pin >= 0 && pin < HOST_PINS) ? hostPins[pin] : 0;
+}
+
+//Heap accounting============================================================
+long hostHeapInUse = 0;
+long hostHeapPeak = 0;
+long hostFailAllocAfter = -1;
+unsigned long hostAllocations = 0;
+void hostHeapResetPeak() { hostHeapPeak = hostHeapInUse; }
+
+#ifdef HOST_HEAP
+#include <malloc.h>
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+
+static bool allocFails() {
+  if (hostFailAllocAfter < 0) return false;
+  if (hostFailAllocAfter == 0) return true;
+  hostFailAllocAfter--;
+  return false;
+}
+
+static void account(long bytes) {
+  hostAllocations++;
+  hostHeapInUse += bytes;
+  if (hostHeapInUse > hostHeapPeak) hostHeapPeak = hostHeapInUse;
+}
+
+void *malloc(size_t size) {
+  if (allocFails()) return NULL;
+  void *p = __libc_malloc(size);
+  if (p) account(malloc_usable_size(p));
+  return p;
+}
+
+void *calloc(size_t count, size_t size) {
+  if (allocFails()) return NULL;
+  void *p = __libc_calloc(count, size);
+  if (p) account(malloc_usable_size(p));
+  return p;
+}
+
+void *realloc(void *p, size_t size) {
+  if (allocFails()) return NULL;
+  long before = p ? malloc_usable_size(p) : 0;
+  void *q = __libc_realloc(p, size);
+  if (q) { hostHeapInUse -= before; account(malloc_usable_size(q)); }
+  return q;
+}
+
+void free(void *p) {
+  if (p) hostHeapInUse -= malloc_usable_size(p);
+  __libc_free(p);
+}
+}
+#endif
+
+//String=====================================================================
+String::String(const char *text) { append(text, strlen(text)); }
+String::String(const String &other) { append(other.buffer, other.len); }
+String::String(char c) { append(&c, 1); }
+String::String(int value) { char s[12]; snprintf(s, sizeof s, "%d", value); append(s, strlen(s)); }
+String::String(unsigned int value) { char s[12]; snprintf(s, sizeof s, "%u", value); append(s, strlen(s)); }
+String::String(long value) { char s[24]; snprintf(s, sizeof s, "%ld", value); append(s, strlen(s)); }
+String::String(unsigned long value) { char s[24]; snprintf(s, sizeof s, "%lu", value); append(s, strlen(s)); }
+String::~String() { free(buffer); }
+
+String &String::operator=(const String &other) {
+  if (this == &other) return *this;
+  len = 0;
+  append(other.buffer, other.len);
+  return *this;
+}
+
+bool String::reserve(unsigned int size) {
+  if (buffer && size <= capacity) return true;
+  char *grown = (char *) realloc(buffer, size + 1);
+  if (grown == NULL) return false;
+  if (buffer == NULL) grown[0] = '\0';
+  buffer = grown;
+  capacity = size;
+  return true;
+}
+
+void String::append(const char *text, unsigned int count) {
+  if (!reserve(len + count)) return;      //Like the Arduino String: out of memory, the text is lost
+  memmove(buffer + len, text, count);
+  len += count;
+  buffer[len] = '\0';
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) { unsigned int t = from; from = to; to = t; }
+  if (from >= len) return String();
+  if (to > len) to = len;
+  String part;
+  part.append(buffer + from, to - from);
+  return part;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  for (unsigned int i = from; i < len; i++) if (buffer[i] == c) return i;
+  return -1;
+}
+
+int String::indexOf(const char *text, unsigned int from) const {
+  if (from >= len) return -1;
+  const char *found = strstr(buffer + from, text);
+  return found ? found - buffer : -1;
+}
+
+String operator+(const String &left, const String &right) { String s(left); s += right; return s; }
+String operator+(const String &left, const char *right) { String s(left); s += right; return s; }
+String operator+(const String &left, char right) { String s(left); s += right; return s; }
+String operator+(char left, const String &right) { String s(left); s += right; return s; }
+String operator+(const char *left, const String &right) { String s(left); s += right; return s; }
+
+//LiquidCrystal==============================================================
+void LiquidCrystal::begin(int columns, int lines) {
+  cols = columns < HOST_LCD_MAX_COLS ? columns : HOST_LCD_MAX_COLS;
+  rows = lines < HOST_LCD_MAX_ROWS ? lines : HOST_LCD_MAX_ROWS;
+  memset(screen, ' ', sizeof screen);
+  col = 0;
+  row = 0;
+}
+
+void LiquidCrystal::clear() {
+  memset(screen, ' ', sizeof screen);
+  col = 0;
+  row = 0;
+  commands++;
+  clears++;
+  hostMicros += HOST_COST_LCD_BYTE + HOST_COST_LCD_CLEAR;
+}
+
+void LiquidCrystal::setCursor(int column, int line) {
+  commands++;
+  hostMicros += HOST_COST_LCD_BYTE;
+  if (column < 0 || column >= cols || line < 0 || line >= rows) badCursors++;
+  col = (uint8_t) column;
+  row = (uint8_t) line;
+}
+
+size_t LiquidCrystal::write(char c) {
+  characters++;
+  hostMicros += HOST_COST_LCD_BYTE;
+  if (row < rows && col < cols) screen[row][col] = c;
+  col++;
+  return 1;
+}
+
+size_t LiquidCrystal::print(const String &s) {
+  for (unsigned int i = 0; i < s.length(); i++) write(s.charAt(i));
+  return s.length();
+}
+
+String LiquidCrystal::line(int r) {
+  String s;
+  for (int c = 0; c < cols; c++) s += screen[r][c];
+  return s;
+}
@@ -0,0 +1,183 @@
+/*
+ * values_test.cpp
+ * Value items: the live values keep being refreshed when the sketch draws the LCD,
+ * and a value wider than the LCD is cut instead of pushing the line (and the cursor) off the screen.
+ */
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+#include <Menu.h>
+#include "check.h"
+
+#define UP 1
+#define DOWN 2
+#define LEFT 3
+#define RIGHT 4
+
+static int sensor = 0;
+static int readSensor() { return sensor; }
+
+//draw==============================================================
+//The showMenu() of a sketch that handles the LCD (MenuV2_Your_LCD)
+//------------------------------------------------------------------
+static bool draw(Menu &menu, LiquidCrystal &lcd, int rows) {
+  if (!menu.needsUpdate()) return false;
+  lcd.clear();
+  for (int i = 0; i < rows; i++) {
+    lcd.setCursor(0, i);
+    lcd.print(menu.lcdLine(i));
+  }
+  menu.updated();
+  return true;
+}
+
+int main() {
+  //The sketch draws: a live value is refreshed again after leaving and re-entering its submenu
+  hostReset();
+  LiquidCrystal screen;
+  screen.begin(16, 2);
+  Menu sketch{String("-SENSORS:000--A1:101[?4]--A2:000-B:000")};
+  sketch.defineLcd(16, 2);
+  sketch.mapKeys(UP, DOWN, LEFT, RIGHT);
+  sketch.bindValue(101, readSensor);
+  CHECK(draw(sketch, screen, 2));
+  sketch.updateWith(RIGHT);                                       //Into SENSORS: A1 is shown
+  CHECK(draw(sketch, screen, 2));
+  CHECK(screen.line(0).indexOf("0") > 0);
+  sketch.updateWith(LEFT);                                        //Back: A1 is not shown
+  CHECK(draw(sketch, screen, 2));
+  hostAdvance(MENU_VALUE_REFRESH * 2000UL);
+  CHECK(!draw(sketch, screen, 2));                                //Nothing to refresh
+  CHECK_EQUAL(sketch.timeToNextTick(), MENU_NO_DEADLINE);
+  sketch.updateWith(RIGHT);                                       //A1 is shown again
+  CHECK(draw(sketch, screen, 2));
+  CHECK(sketch.timeToNextTick() <= MENU_VALUE_REFRESH);           //Its refresh is scheduled
+  sensor = 42;
+  hostAdvance(MENU_VALUE_REFRESH * 1000UL);
+  CHECK(draw(sketch, screen, 2));                                 //The sketch is told to redraw
+  CHECK(screen.line(0).indexOf("42") > 0);
+
+  //A value wider than the LCD is cut to LCDcol - 2 columns
+  hostReset();
+  LiquidCrystal lcd;
+  lcd.begin(16, 2);
+  int language = 0;
+  Menu menu{String("-LANGUAGE:202[ENGLISH (US)|FRANCAIS (CANADA)]-B:000")};
+  CHECK_EQUAL(menu.getParseError(), MENU_OK);
+  menu.handleLcd(&lcd, 16, 2);
+  menu.mapKeys(UP, DOWN, LEFT, RIGHT);
+  menu.bindValue(202, &language);
+  hostAdvance(MENU_REDRAW_INTERVAL * 1000UL);
+  menu.showMenu();
+  CHECK_EQUAL(menu.lcdLine(0).length(), 16);
+  CHECK(lcd.line(0) == menu.lcdLine(0));
+  menu.updateWith(RIGHT);                                         //Edit it in place
+  menu.updateWith(UP);
+  CHECK_EQUAL(language, 1);
+  CHECK(lcd.line(0) == menu.lcdLine(0));                          //Only the field was redrawn, at column 2
+  CHECK(lcd.line(0) == "* FRANCAIS (CANA");
+  CHECK_EQUAL(lcd.badCursors, 0);
+  CHECK_EQUAL(menu.lcdBytes(), lcd.bytes());
+
+  //A narrow value keeps the label and the value on one line
+  Menu narrow{String("-CONTRAST LEVEL:201[0..100]")};
+  narrow.defineLcd(8, 1);
+  int contrast = 7;
+  narrow.bindValue(201, &contrast);
+  CHECK(narrow.lcdLine(0) == ">CON   7");
+
+  //The library draws: editing and refreshing send only the value field (or the caret)
+  hostReset();
+  LiquidCrystal full;
+  full.begin(16, 3);
+  Menu edited{String("-VOLUME:201[0..3]-MODE:202[A|B|C]-SENSOR:203[?]")};
+  edited.handleLcd(&full, 16, 3);
+  edited.mapKeys(UP, DOWN, LEFT, RIGHT);
+  int level = 9;                                                  //Outside of [0..3]
+  int mode = 0;
+  sensor = 0;
+  edited.bindValue(201, &level);
+  edited.bindValue(202, &mode);
+  edited.bindValue(203, readSensor);
+  hostAdvance(MENU_REDRAW_INTERVAL * 1000UL);
+  edited.showMenu();
+  unsigned long clears = full.clears;
+  unsigned long bytes = full.bytes();
+  edited.updateWith(RIGHT);                                       //Edit VOLUME: only the caret
+  CHECK(full.line(0) == edited.lcdLine(0));
+  CHECK_EQUAL(full.line(0).charAt(0), '*');
+  CHECK_EQUAL(full.bytes() - bytes, 2);                           //setCursor() and "*"
+  bytes = full.bytes();
+  edited.updateWith(UP);                                          //Clamped into the range
+  CHECK_EQUAL(level, 3);
+  CHECK_EQUAL(full.bytes() - bytes, 2);                           //setCursor() and the 1 column field
+  CHECK(full.line(0) == edited.lcdLine(0));
+  edited.updateWith(UP);                                          //Stops at the maximum
+  CHECK_EQUAL(level, 3);
+  for (int i = 0; i < 5; i++) edited.updateWith(DOWN);            //Stops at the minimum
+  CHECK_EQUAL(level, 0);
+  CHECK(full.line(0) == edited.lcdLine(0));
+  bytes = full.bytes();
+  edited.updateWith(LEFT);                                        //Ends the edition: only the caret
+  CHECK_EQUAL(full.line(0).charAt(0), '>');
+  CHECK_EQUAL(full.bytes() - bytes, 2);
+  edited.updateWith(UP);                                          //Navigates again
+  CHECK_EQUAL(level, 0);
+
+  edited.updateWith(DOWN);                                        //MODE: an enum wraps both ways
+  hostAdvance(MENU_REDRAW_INTERVAL * 1000UL);
+  edited.showMenu();
+  clears = full.clears;
+  edited.updateWith(RIGHT);
+  edited.updateWith(DOWN);
+  CHECK_EQUAL(mode, 2);
+  CHECK(full.line(1) == edited.lcdLine(1));
+  edited.updateWith(UP);
+  CHECK_EQUAL(mode, 0);
+  edited.updateWith(UP);
+  CHECK_EQUAL(mode, 1);
+  bytes = full.bytes();
+  edited.updateWith(RIGHT);                                       //RIGHT ends it too
+  CHECK_EQUAL(full.line(1).charAt(0), '>');
+  CHECK_EQUAL(full.bytes() - bytes, 2);
+  CHECK_EQUAL(full.clears, clears);                               //No redraw of the whole LCD
+
+  bytes = full.bytes();                                           //SENSOR: a live refresh
+  hostAdvance(MENU_VALUE_REFRESH * 1000UL);
+  edited.showMenu();
+  CHECK_EQUAL(full.bytes(), bytes);                               //Unchanged: nothing sent
+  sensor = 42;
+  hostAdvance(MENU_VALUE_REFRESH * 1000UL);
+  edited.showMenu();
+  CHECK_EQUAL(full.bytes() - bytes, 1 + MENU_LIVE_WIDTH);         //setCursor() and the field
+  CHECK(full.line(2) == edited.lcdLine(2));
+  CHECK(full.line(2).indexOf("42") > 0);
+  CHECK_EQUAL(full.clears, clears);
+  CHECK_EQUAL(edited.lcdBytes(), full.bytes());
+
+  //The current item changes while its value is edited: the edition ends, a live item is never written
+  Menu moved{String("-VOLUME:102[0..3]-SENSOR:103[?]")};
+  moved.defineLcd(16, 2);
+  moved.mapKeys(UP, DOWN, LEFT, RIGHT);
+  int volume = 1;
+  moved.bindValue(102, &volume);
+  moved.bindValue(103, readSensor);
+  moved.updateWith(RIGHT);                                        //Edit VOLUME
+  CHECK(moved.lcdLine(0).charAt(0) == '*');
+  moved.setCurrentItem("SENSOR");
+  CHECK(moved.getCurrentLabel() == "SENSOR");
+  CHECK(moved.lcdLine(1).charAt(0) == '>');
+  moved.updateWith(UP);                                           //Navigates, does not edit SENSOR
+  CHECK(moved.getCurrentLabel() == "VOLUME");
+  CHECK_EQUAL(volume, 1);
+  moved.updateWith(RIGHT);
+  moved.setCurrentItem("VOLUME");                                 //Even on the same item
+  CHECK(moved.lcdLine(0).charAt(0) == '>');
+  moved.updateWith(UP);
+  CHECK_EQUAL(volume, 1);
+  moved.setCurrentItem("SENSOR");
+  moved.setCurrentItem("VOLUME");                                 //The label is compared, not assigned
+  CHECK(moved.getCurrentLabel() == "VOLUME");
+
+  return checkDone("values_test");
+}